@@ -0,0 +1,103 @@
+/* clock.c: monotonic nanosecond clock from the TSC
+ * clock_init measures the TSC against a CALIBRATE_MS one-shot on PIT channel 2, the same
+ * crystal the tick comes from. Converting cycles to nanoseconds is then a multiply and a
+ * shift by the fixed point clock_mult = 10^6 / tsc_khz, with no division on the read path.
+ */
+
+#include "clock.h"
+#include "lib.h"
+#include "system_call.h"
+
+uint32_t tsc_khz = 0;       // TSC cycles per millisecond
+uint32_t clock_mult = 0;    // nanoseconds per cycle << CLOCK_SHIFT
+uint64_t tsc_base = 0;      // TSC at clock_init, time zero
+
+/* uint32_t div_u64(uint64_t n, uint32_t d, uint32_t* rem);
+ * Inputs: uint64_t n -- dividend
+ *         uint32_t d -- divisor, not 0
+ *         uint32_t* rem -- remainder, may be NULL
+ * Return Value: n / d, the quotient must fit in 32 bits
+ *  Function: 64 by 32 bit division with divl, the kernel is not linked with libgcc */
+uint32_t div_u64(uint64_t n, uint32_t d, uint32_t* rem){
+    uint32_t quot, r;
+    asm volatile ("divl %4"
+                    : "=a"(quot), "=d"(r)
+                    : "a"((uint32_t)n), "d"((uint32_t)(n >> 32)), "rm"(d)
+                    : "cc"
+                    );
+    if(rem != NULL){
+        *rem = r;
+    }
+    return quot;
+}
+
+/* void clock_init(void);
+ * Inputs: none
+ * Return Value: none
+ *  Function: calibrates the TSC with PIT channel 2 and starts the clock at 0. Busy waits
+ *            CALIBRATE_MS, call once at boot. */
+void clock_init(void){
+    uint32_t flags;
+    uint8_t gate;
+    uint64_t start, end;
+
+    cli_and_save(flags);
+    gate = inb(PIT_CH2_GATE_PORT);
+    outb((gate & ~PIT_SPEAKER) & ~PIT_CH2_GATE, PIT_CH2_GATE_PORT);  // stop channel 2, speaker off
+    outb(PIT_CH2_ONESHOT, PIT_CMD_PORT);
+    outb(CALIBRATE_COUNT & 0xFF, PIT_CH2_DATA);
+    outb((CALIBRATE_COUNT >> 8) & 0xFF, PIT_CH2_DATA);
+
+    outb((gate & ~PIT_SPEAKER) | PIT_CH2_GATE, PIT_CH2_GATE_PORT);   // start counting
+    start = rdtsc();
+    while(!(inb(PIT_CH2_GATE_PORT) & PIT_CH2_OUT));                  // OUT2 rises at terminal count
+    end = rdtsc();
+    outb(gate, PIT_CH2_GATE_PORT);
+    restore_flags(flags);
+
+    tsc_khz = (uint32_t)(end - start) / CALIBRATE_MS;
+    if(tsc_khz < CLOCK_MIN_KHZ){    // keeps clock_mult within 32 bits
+        tsc_khz = CLOCK_MIN_KHZ;
+    }
+    clock_mult = div_u64((uint64_t)NS_PER_MS << CLOCK_SHIFT, tsc_khz, NULL);
+    tsc_base = rdtsc();
+}
+
+/* uint64_t cycles_to_ns(uint64_t cycles);
+ * Inputs: uint64_t cycles -- TSC cycles
+ * Return Value: the same time in nanoseconds
+ *  Function: (cycles * clock_mult) >> CLOCK_SHIFT, with a 96 bit product so it never wraps */
+uint64_t cycles_to_ns(uint64_t cycles){
+    uint64_t lo = (uint64_t)(uint32_t)cycles * clock_mult;
+    uint64_t hi = (uint64_t)(uint32_t)(cycles >> 32) * clock_mult;
+    return (hi << (32 - CLOCK_SHIFT)) + (lo >> CLOCK_SHIFT);
+}
+
+/* uint64_t clock_ns(void);
+ * Inputs: none
+ * Return Value: nanoseconds since clock_init
+ *  Function: monotonic clock, safe in interrupt handlers */
+uint64_t clock_ns(void){
+    return cycles_to_ns(rdtsc() - tsc_base);
+}
+
+/* int32_t clock_gettime(int32_t clock_id, timespec_t* ts);
+ * Inputs: int32_t clock_id -- CLOCK_MONOTONIC
+ *         timespec_t* ts -- user buffer for the time
+ * Return Value: 0 on success, -1 for a bad clock or a pointer outside the user page
+ *  Function: system call, stores the time since boot as seconds and nanoseconds */
+int32_t clock_gettime(int32_t clock_id, timespec_t* ts){
+    uint64_t now;
+    uint32_t nsec;
+
+    if(clock_id != CLOCK_MONOTONIC){
+        return FAIL_NEG_ONE;
+    }
+    if((uint32_t)ts < MB_128 || (uint32_t)ts > ONE_THIRTY_TWO_MB - sizeof(timespec_t)){
+        return FAIL_NEG_ONE;
+    }
+    now = clock_ns();
+    ts->tv_sec = div_u64(now, NS_PER_SEC, &nsec);
+    ts->tv_nsec = nsec;
+    return 0;
+}
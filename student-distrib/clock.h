@@ -0,0 +1,41 @@
+/* clock.h: monotonic nanosecond clock from the TSC, calibrated against the PIT */
+
+#ifndef _CLOCK_H
+#define _CLOCK_H
+
+#include "types.h"
+
+#define PIT_FREQUENCY       1193182     // Hz
+#define PIT_CH2_DATA        0x42
+#define PIT_CMD_PORT        0x43
+#define PIT_CH2_GATE_PORT   0x61        // bit 0 gates channel 2, bit 1 the speaker, bit 5 is OUT2
+#define PIT_CH2_GATE        0x01
+#define PIT_SPEAKER         0x02
+#define PIT_CH2_OUT         0x20
+#define PIT_CH2_ONESHOT     0xB0        // channel 2, lobyte/hibyte, mode 0, binary
+
+#define CALIBRATE_MS        50
+#define CALIBRATE_COUNT     (PIT_FREQUENCY * CALIBRATE_MS / 1000)    // fits the 16-bit counter
+#define CLOCK_SHIFT         22          // fixed point bits of clock_mult
+#define CLOCK_MIN_KHZ       1000
+#define NS_PER_MS           1000000
+#define NS_PER_SEC          1000000000
+
+#define CLOCK_MONOTONIC     0           // clock_gettime: time since boot
+
+typedef struct timespec_t {
+    uint32_t tv_sec;
+    uint32_t tv_nsec;
+} timespec_t;
+
+extern uint32_t tsc_khz;
+extern uint32_t clock_mult;
+extern uint64_t tsc_base;
+
+void clock_init(void);
+uint64_t clock_ns(void);
+uint64_t cycles_to_ns(uint64_t cycles);
+uint32_t div_u64(uint64_t n, uint32_t d, uint32_t* rem);
+int32_t clock_gettime(int32_t clock_id, timespec_t* ts);
+
+#endif /* _CLOCK_H */
@@ -1,5 +1,7 @@
 #include "filesys.h"
 #include "system_call.h"
+#include "thread.h"
+#include "procfs.h"
 
 /* void init_filesys()
  * Sets pointers to start of blocks
@@ -173,7 +175,7 @@ uint32_t read_data(uint32_t inode_index, uint32_t offset, uint8_t* buf, uint32_t
  */
 int32_t file_read(int32_t fd, void* buf, int32_t nbytes){ // TODO: offset
     int i;
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    pcb_struct* pcb = files_pcb();
     uint32_t read_bytes;
 
     // Check if the file is closed
@@ -225,7 +227,7 @@ int32_t file_open(const uint8_t* filename){ // TODO: remove int32_t fd for the n
     // If the named file does not exist or no descriptors are free, the call returns -1.
 
     dentry_t dentry;
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    pcb_struct* pcb = files_pcb();
     int i;
     int32_t fd = -1;   //invalid fd (used if all fd slots are open/unavailable)  
 
@@ -251,6 +253,7 @@ int32_t file_open(const uint8_t* filename){ // TODO: remove int32_t fd for the n
         pcb->file_descriptor[fd].inode = dentry.inode_num; // 0 for directories and RTC
         pcb->file_descriptor[fd].file_position = 0; // starts at the initial position
         pcb->file_descriptor[fd].flags = 1; // descriptor in-use
+        pcb->file_descriptor[fd].mode = 0;
     }else{
         return -1; // descriptor is not free
     }
@@ -266,7 +269,7 @@ int32_t file_open(const uint8_t* filename){ // TODO: remove int32_t fd for the n
  */
 
 int32_t file_close(int32_t fd){
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    pcb_struct* pcb = files_pcb();
     if(fd < FD_MIN || fd > FD_MAX){ // invalid descriptor (none existing, stdin, stdout)
         return -1;
     }
@@ -296,7 +299,7 @@ int32_t directory_read(int32_t fd, void* buf, int32_t nbytes){
     
     dentry_t dentry;
     int idx;
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    pcb_struct* pcb = files_pcb();
 
     // Check for invalid descriptor
     if(fd < FD_MIN || fd > FD_MAX){ // invalid descriptor (none existing, stdin, stdout)
@@ -308,8 +311,9 @@ int32_t directory_read(int32_t fd, void* buf, int32_t nbytes){
         return -1;
     }
 
-    // If the initial file position is at or beyond the end of file, 0 shall be returned 
-    if(pcb->file_descriptor[fd].file_position >= bb->dir_count){
+    // If the initial file position is at or beyond the end of file, 0 shall be returned,
+    // the synthetic files of procfs.c are listed after the entries of the image
+    if(pcb->file_descriptor[fd].file_position >= bb->dir_count + procfs_count()){
         return 0;
     }
 
@@ -320,7 +324,9 @@ int32_t directory_read(int32_t fd, void* buf, int32_t nbytes){
     memset(buf, 0, nbytes);
 
     // Grab the dentry
-    if(read_dentry_by_index(pcb->file_descriptor[fd].file_position, &dentry) == -1){ 
+    if(pcb->file_descriptor[fd].file_position >= bb->dir_count){
+        procfs_dentry_by_index(pcb->file_descriptor[fd].file_position - bb->dir_count, &dentry);
+    }else if(read_dentry_by_index(pcb->file_descriptor[fd].file_position, &dentry) == -1){ 
         return -1;//failed
     }
 
@@ -366,7 +372,7 @@ int32_t directory_open(const uint8_t* filename){
     //RTC device, or regular file)
 
     dentry_t dentry;
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    pcb_struct* pcb = files_pcb();
     
     int i;
     int32_t fd = -1;   //invalid fd (used if all fd slots are open/unavailable)  
@@ -393,6 +399,7 @@ int32_t directory_open(const uint8_t* filename){
         pcb->file_descriptor[fd].inode = 0; // 0 for directories and RTC
         pcb->file_descriptor[fd].file_position = 0; // starts at the initial position
         pcb->file_descriptor[fd].flags = 1; // descriptor in-use
+        pcb->file_descriptor[fd].mode = 0;
     }else{
         return -1; // descriptor is not free
     }
@@ -406,7 +413,7 @@ int32_t directory_open(const uint8_t* filename){
  * side effects: none
  */
 int32_t directory_close(int32_t fd){
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    pcb_struct* pcb = files_pcb();
 
     if(fd < FD_MIN || fd > FD_MAX){ // invalid descriptor (none existing, stdin, stdout)
         return -1;
@@ -3,6 +3,8 @@
 
 #include "types.h"
 #include "lib.h"
+#include "fpu.h"
+#include "signal.h"
 
 #define BB_RESERVED             52
 #define BB_DENTRIES             63
@@ -14,12 +16,15 @@
 #define RTC_FILE_TYPE           0
 #define DIRECTORY_FILE_TYPE     1
 #define REGULAR_FILE_TYPE       2
+#define PROC_FILE_TYPE          3   // generated on every read by procfs.c, not in the image
 #define FD_MIN                  2
 #define FD_MAX                  7
 #define EIGHT_MB    0x800000
 #define FOUR_MB     0x400000
 #define TWELVE_MB   0xC00000
 #define EIGHT_KB    8192
+#define ARGS_LEN    128     // a command line is at most one terminal line
+#define PCB_SYS_CALLS   30      // NUM_SYS_CALLS, idt_number.h cannot be included here
 
 extern int32_t process_num;
 
@@ -48,6 +53,7 @@ typedef struct {
     int32_t (*close)(int32_t fd);
     int32_t (*read)(int32_t fd, void* buf, int32_t n);
     int32_t (*write)(int32_t fd, const void* buf, int32_t n);
+    int32_t (*poll)(int32_t fd);        // POLLIN/POLLOUT/... bits ready now, NULL if it never blocks
 } fop_table_t;
 
 typedef struct file_descriptor {
@@ -55,6 +61,7 @@ typedef struct file_descriptor {
     uint32_t inode;
     uint32_t file_position;
     uint32_t flags; // Open == 1 (in-use)
+    uint32_t mode;  // TERM_RAW/TERM_NONBLOCK bits set through ioctl (terminal only)
 }file_descriptor;
 
 typedef struct file_array {
@@ -79,8 +86,48 @@ typedef struct pcb_struct {
     uint32_t terminal_num;                  // Process's terminal number
     uint32_t pingpong;                      // Label this as pingpong for terminal
     file_descriptor file_descriptor[8];     // File descriptor array
+    volatile uint32_t state;                // PROC_RUNNABLE or PROC_BLOCKED
+    uint32_t timed_out;                     // the last block_current ended by its deadline
+    uint32_t sig_woken;                     // the last block_current ended by send_signal
+    uint64_t wake_time;                     // clock_ns deadline while on the timer queue
+    struct pcb_struct* timer_next;          // timer queue link, sorted by wake_time
+    uint32_t on_timer_queue;
+    struct uring_t* uring;                  // rings registered with uring_setup, NULL if none
+    struct pcb_struct* wait_next;           // wait queue link
+    struct wait_queue_t* wait_queue;        // queue the process sleeps on, NULL if none
+    int32_t slot;                           // index in schedule_array the process runs from
+    uint32_t spawned;                       // started by spawn, owns a background slot
+    uint32_t fresh;                         // never ran, the scheduler enters it at entry_point
+    uint8_t args[ARGS_LEN];                 // arguments for getargs
+    uint8_t name[DENTRY_FILE_NAME_LEN + 1]; // program file name, or the kernel thread's name
+    uint32_t shm_attached;                  // bit i set while shared segment i is mapped
+    uint32_t shm_held;                      // bit i set while the process holds a reference on segment i
+    uint32_t futex_addr;                    // physical address of the word slept on, 0 if none
+    uint32_t sig_pending;                   // bit per signal raised and not delivered yet
+    uint32_t sig_blocked;                   // bit per signal held back, all while a handler runs
+    uint32_t sig_handler[NUM_SIGNALS];      // user handler addresses, 0 for the default action
+    uint32_t zombie;                        // spawned child that halted, kept until waitpid
+    int32_t exit_status;                    // status of a zombie
+    uint32_t in_waitpid;                    // sleeping in waitpid, a halting child wakes it
+    struct pcb_struct* first_child;         // spawned children, live or zombie
+    struct pcb_struct* next_sibling;        // next spawned child of the same parent
+    uint32_t kthread;                       // kernel thread, entry_point is its function
+    uint32_t kthread_data;                  // argument of the kernel thread function
+    struct pcb_struct* group_leader;        // process a thread belongs to, NULL for a process
+    struct pcb_struct* next_thread;         // threads of a leader, linked from the leader
+    struct pcb_struct* joiner;              // task waiting in thread_join for this thread
+    uint32_t user_esp;                      // first user stack pointer of a thread
+    uint32_t fpu_used;                      // fpu holds state, the task has used the FPU
+    fpu_state_t fpu;                        // FPU registers while another task owns them
+    uint32_t sys_calls[PCB_SYS_CALLS];      // system calls made by the process and its threads
+    uint64_t sys_cycles[PCB_SYS_CALLS];     // and the TSC cycles they took, see sysstat.c
+    uint32_t sched_ticks;                   // PIT ticks that found the task running
+    uint32_t sched_switches;                // times the scheduler switched to it
 }pcb_struct;
 
+#define PROC_RUNNABLE   0
+#define PROC_BLOCKED    1
+
 /* Initialize file system */
 void init_filesys(uint32_t* addr);
 
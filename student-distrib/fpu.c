@@ -0,0 +1,182 @@
+/* fpu.c: lazy x87/SSE state switching for user programs
+ * The FPU registers are not saved on every task switch. Instead CR0.TS is set when a task
+ * other than the one whose state is in the registers (fpu_owner) starts running, so its
+ * first x87, MMX or SSE instruction raises #NM. fpu_trap then saves the owner's registers
+ * in the owner's PCB, loads the running task's (or a clean image on its first use), makes it
+ * the owner and clears TS. Tasks that never touch the FPU never trap and never pay for a
+ * save or restore. The kernel itself only uses xmm0-xmm3, between kernel_fpu_begin and
+ * kernel_fpu_end, which keep whatever task state the registers hold.
+ */
+
+#include "fpu.h"
+#include "lib.h"
+#include "filesys.h"
+#include "sysenter.h"
+#include "timer.h"
+
+uint32_t fpu_enabled = 0;
+uint32_t fpu_has_sse2 = 0;
+pcb_struct* fpu_owner = NULL;
+static fpu_state_t fpu_init_state;      // registers right after fninit, for a first use
+
+/* static inline uint32_t read_cr0(void) / write_cr0(uint32_t val)
+ * Function: access CR0 */
+static inline uint32_t read_cr0(void){
+    uint32_t val;
+    asm volatile ("movl %%cr0, %0" : "=r"(val));
+    return val;
+}
+
+static inline void write_cr0(uint32_t val){
+    asm volatile ("movl %0, %%cr0" : : "r"(val) : "memory");
+}
+
+/* static inline void fxsave(fpu_state_t* state) / fxrstor(fpu_state_t* state)
+ * Function: save or load all x87, MMX and SSE registers */
+static inline void fxsave(fpu_state_t* state){
+    asm volatile ("fxsave %0" : "=m"(*state));
+}
+
+static inline void fxrstor(fpu_state_t* state){
+    asm volatile ("fxrstor %0" : : "m"(*state));
+}
+
+/* void fpu_init(void)
+ * inputs: none
+ * outputs: none
+ * Function: enables the FPU and SSE when the CPU has FXSAVE, records a clean register image
+ *           and sets TS so the first use traps. Without FXSAVE, CR0.EM is set and every FPU
+ *           instruction ends the program like any other fault.
+ */
+void fpu_init(void){
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t cr4;
+    uint32_t mxcsr = MXCSR_DEFAULT;
+
+    asm volatile ("cpuid"
+                    : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                    : "a"(CPUID_FEATURES)
+                    );
+    fpu_owner = NULL;
+    if(!(edx & CPUID_EDX_FPU) || !(edx & CPUID_EDX_FXSR)){
+        fpu_enabled = 0;
+        write_cr0(read_cr0() | CR0_EM);
+        return;
+    }
+
+    write_cr0((read_cr0() & ~(CR0_EM | CR0_TS)) | CR0_MP | CR0_NE);
+    asm volatile ("movl %%cr4, %0" : "=r"(cr4));
+    cr4 |= CR4_OSFXSR;
+    if(edx & CPUID_EDX_SSE){
+        cr4 |= CR4_OSXMMEXCPT;
+    }
+    asm volatile ("movl %0, %%cr4" : : "r"(cr4) : "memory");
+
+    asm volatile ("fninit");
+    if(edx & CPUID_EDX_SSE){
+        asm volatile ("ldmxcsr %0" : : "m"(mxcsr));
+    }
+    fxsave(&fpu_init_state);
+    write_cr0(read_cr0() | CR0_TS);
+    fpu_has_sse2 = (edx & CPUID_EDX_SSE2) ? 1 : 0;
+    fpu_enabled = 1;
+}
+
+/* int32_t fpu_trap(void)
+ * inputs: none
+ * outputs: 1 if the #NM was handled and the instruction can run again, 0 if the FPU is off
+ * Function: #NM handler, makes the running task the owner of the FPU registers
+ */
+int32_t fpu_trap(void){
+    pcb_struct* pcb = current_pcb();
+    uint32_t flags;
+
+    if(!fpu_enabled){
+        return 0;
+    }
+    cli_and_save(flags);
+    asm volatile ("clts");
+    if(fpu_owner != pcb){
+        if(fpu_owner != NULL){
+            fxsave(&fpu_owner->fpu);
+        }
+        fxrstor(pcb->fpu_used ? &pcb->fpu : &fpu_init_state);
+        fpu_owner = pcb;
+        pcb->fpu_used = 1;
+    }
+    restore_flags(flags);
+    return 1;
+}
+
+/* void fpu_switch(pcb_struct* next)
+ * inputs: next -- task about to run
+ * outputs: none
+ * Function: called on every switch of the running task, lets next use the registers
+ *           without a trap only when they hold its state already
+ */
+void fpu_switch(pcb_struct* next){
+    if(!fpu_enabled){
+        return;
+    }
+    if(next == fpu_owner){
+        asm volatile ("clts");
+    }else{
+        write_cr0(read_cr0() | CR0_TS);
+    }
+}
+
+/* void fpu_release(pcb_struct* pcb)
+ * inputs: pcb -- task that ends or starts a new program
+ * outputs: none
+ * Function: forgets its FPU state, the registers are not saved for it any more
+ */
+void fpu_release(pcb_struct* pcb){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if(fpu_owner == pcb){
+        fpu_owner = NULL;
+    }
+    pcb->fpu_used = 0;
+    restore_flags(flags);
+}
+
+/* void kernel_fpu_begin(kernel_fpu_t* save)
+ * inputs: save -- filled with what kernel_fpu_end puts back
+ * outputs: none
+ * Function: lets kernel code use xmm0-xmm3 until kernel_fpu_end. Interrupts stay off in
+ *           between so no task switch sees the kernel's values. Only call when fpu_has_sse2.
+ */
+void kernel_fpu_begin(kernel_fpu_t* save){
+    cli_and_save(save->flags);
+    save->cr0 = read_cr0();
+    asm volatile ("clts");
+    asm volatile ("movdqu %%xmm0, 0(%0)\n\
+                    movdqu %%xmm1, 16(%0)\n\
+                    movdqu %%xmm2, 32(%0)\n\
+                    movdqu %%xmm3, 48(%0)"
+                    :
+                    : "r"(save->xmm)
+                    : "memory"
+                    );
+}
+
+/* void kernel_fpu_end(kernel_fpu_t* save)
+ * inputs: save -- from the matching kernel_fpu_begin
+ * outputs: none
+ * Function: puts back xmm0-xmm3, TS and the interrupt flag
+ */
+void kernel_fpu_end(kernel_fpu_t* save){
+    asm volatile ("movdqu 0(%0), %%xmm0\n\
+                    movdqu 16(%0), %%xmm1\n\
+                    movdqu 32(%0), %%xmm2\n\
+                    movdqu 48(%0), %%xmm3"
+                    :
+                    : "r"(save->xmm)
+                    : "memory"
+                    );
+    if(save->cr0 & CR0_TS){
+        write_cr0(read_cr0() | CR0_TS);
+    }
+    restore_flags(save->flags);
+}
@@ -0,0 +1,50 @@
+/* fpu.h: lazy x87/SSE state switching for user programs */
+
+#ifndef _FPU_H
+#define _FPU_H
+
+#include "types.h"
+
+#define CPUID_EDX_FPU       (1 << 0)    // x87 on chip
+#define CPUID_EDX_FXSR      (1 << 24)   // FXSAVE/FXRSTOR
+#define CPUID_EDX_SSE       (1 << 25)
+#define CPUID_EDX_SSE2      (1 << 26)
+
+#define CR0_MP              (1 << 1)    // WAIT traps when TS is set
+#define CR0_EM              (1 << 2)    // no FPU, every FPU instruction traps
+#define CR0_TS              (1 << 3)    // task switched, the next FPU instruction traps
+#define CR0_NE              (1 << 5)    // report x87 errors as exception 16
+#define CR4_OSFXSR          (1 << 9)    // FXSAVE saves SSE state, SSE allowed
+#define CR4_OSXMMEXCPT      (1 << 10)   // SSE errors as exception 19
+
+#define MXCSR_DEFAULT       0x1F80      // all SSE exceptions masked, round to nearest
+#define FXSAVE_SIZE         512
+
+/* FXSAVE image of the x87, MMX and SSE registers */
+typedef struct fpu_state_t {
+    uint8_t data[FXSAVE_SIZE];
+} __attribute__((aligned (16))) fpu_state_t;
+
+#define KERNEL_FPU_XMM      4           // xmm0-xmm3 are free between kernel_fpu_begin and end
+
+/* what kernel_fpu_begin saves for kernel_fpu_end */
+typedef struct kernel_fpu_t {
+    uint8_t xmm[KERNEL_FPU_XMM * 16];
+    uint32_t cr0;
+    uint32_t flags;
+} kernel_fpu_t;
+
+struct pcb_struct;
+
+extern uint32_t fpu_enabled;            // FPU and FXSR present, CR0 and CR4 set up
+extern uint32_t fpu_has_sse2;
+extern struct pcb_struct* fpu_owner;    // task whose state is in the registers, NULL if none
+
+void fpu_init(void);
+int32_t fpu_trap(void);
+void fpu_switch(struct pcb_struct* next);
+void fpu_release(struct pcb_struct* pcb);
+void kernel_fpu_begin(kernel_fpu_t* save);
+void kernel_fpu_end(kernel_fpu_t* save);
+
+#endif /* _FPU_H */
@@ -0,0 +1,89 @@
+/* futex.c: sleeping on user words
+ * A program keeps its lock or counter in an ordinary word and only enters the kernel when
+ * it has to wait or somebody is waiting. Waiters are keyed by the physical address of the
+ * word, so the same word reached through a shared segment matches in every process, and
+ * sleep on one of FUTEX_HASH_SIZE wait queues. A waker takes waiters for its word off the
+ * bucket by clearing their futex_addr, they leave the queue when they next run.
+ * There is no timeout. A waiter whose waker died, say a peer program that faulted while it
+ * held the lock, sleeps until a signal such as ctrl+c wakes it, and futex_wait returns -1.
+ */
+
+#include "futex.h"
+#include "lib.h"
+#include "paging.h"
+#include "system_call.h"
+#include "timer.h"
+
+static wait_queue_t futex_queues[FUTEX_HASH_SIZE];
+
+/* static uint32_t futex_key(uint32_t* addr);
+ * Inputs: uint32_t* addr -- user word
+ * Return Value: physical address of the word, 0 if it is misaligned or not user memory
+ *  Function: turns a user pointer into the key waiters are matched by */
+static uint32_t futex_key(uint32_t* addr){
+    if((uint32_t)addr & (sizeof(uint32_t) - 1)){
+        return 0;
+    }
+    return user_phys_addr((uint32_t)addr);
+}
+
+/* int32_t futex_wait(uint32_t* addr, uint32_t val);
+ * Inputs: uint32_t* addr -- aligned word in the user page or an attached shared segment
+ *         uint32_t val -- value the caller last saw in the word
+ * Return Value: 0 once woken by futex_wake, -1 on a bad address, if the word no longer
+ *               holds val or if a signal arrived first, in which case the caller must not
+ *               assume the word changed
+ *  Function: system call, sleeps while *addr == val. The test and the sleep happen with
+ *            interrupts disabled, so a futex_wake after the word changes is never lost. */
+int32_t futex_wait(uint32_t* addr, uint32_t val){
+    pcb_struct* pcb = current_pcb();
+    uint32_t key = futex_key(addr);
+
+    if(key == 0){
+        return FAIL_NEG_ONE;
+    }
+    cli();
+    if(*addr != val){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+    pcb->futex_addr = key;
+    while(pcb->futex_addr == key){              // cleared by futex_wake
+        if(wait_event(&futex_queues[FUTEX_HASH(key)], TIMER_NO_DEADLINE) == -1){
+            if(pcb->futex_addr != key){         // futex_wake came first and counted it
+                break;
+            }
+            pcb->futex_addr = 0;
+            sti();
+            return FAIL_NEG_ONE;
+        }
+    }
+    sti();
+    return 0;
+}
+
+/* int32_t futex_wake(uint32_t* addr, uint32_t n);
+ * Inputs: uint32_t* addr -- word waiters sleep on
+ *         uint32_t n -- most waiters to wake
+ * Return Value: number of waiters woken, -1 on a bad address
+ *  Function: system call, wakes up to n processes waiting on the word, newest first */
+int32_t futex_wake(uint32_t* addr, uint32_t n){
+    uint32_t key = futex_key(addr);
+    uint32_t flags;
+    pcb_struct* pcb;
+    uint32_t woken = 0;
+
+    if(key == 0){
+        return FAIL_NEG_ONE;
+    }
+    cli_and_save(flags);
+    for(pcb = futex_queues[FUTEX_HASH(key)].head; pcb != NULL && woken < n; pcb = pcb->wait_next){
+        if(pcb->futex_addr == key){
+            pcb->futex_addr = 0;
+            wake_process(pcb);
+            woken++;
+        }
+    }
+    restore_flags(flags);
+    return (int32_t)woken;
+}
@@ -0,0 +1,15 @@
+/* futex.h: sleeping on user words */
+
+#ifndef _FUTEX_H
+#define _FUTEX_H
+
+#include "types.h"
+
+#define FUTEX_HASH_SIZE     16                  // power of two, buckets of waiters
+#define FUTEX_HASH(phys)    (((phys) >> 2) & (FUTEX_HASH_SIZE - 1))
+
+/* system calls */
+int32_t futex_wait(uint32_t* addr, uint32_t val);
+int32_t futex_wake(uint32_t* addr, uint32_t n);
+
+#endif /* _FUTEX_H */
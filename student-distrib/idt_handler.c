@@ -7,17 +7,35 @@
 #include "i8259.h"
 #include "rtc.h"
 #include "pit.h"
+#include "softirq.h"
+#include "serial.h"
+#include "signal.h"
+#include "fpu.h"
+#include "prof.h"
 
 extern int32_t system_halt (uint8_t status);
 extern int32_t exception_halt (uint16_t status);
 
-/* void exc_handler(int intr_num)
+uint32_t exc_counts[NUM_EXCEPTIONS];
+uint32_t irq_counts[NUM_IRQS];
+
+/* void exc_handler(int intr_num, hw_context_t* regs)
  * inputs: int intr_num - INT # for exception
+ *         hw_context_t* regs - registers saved by the linkage
  * outputs: void
- * Function: prints the exception name for the given INT number and freezes the system
+ * Function: loads the FPU state for a #NM, hands other faults to the program's signal handler
+ *           if it has one, otherwise prints the exception name for the given INT number and
+ *           freezes the system
  */
-void exc_handler(int intr_num){
+void exc_handler(int intr_num, hw_context_t* regs){
     uint16_t status = EXEC_STATUS;
+    exc_counts[intr_num]++;     // #NM traps of the lazy FPU switch count too
+    if(intr_num == coprocessor_na && fpu_trap()){
+        return;     // FPU state loaded, the instruction runs again
+    }
+    if(signal_from_exception(intr_num, regs)){
+        return;     // delivered by ret_from_intr
+    }
     switch (intr_num)
     {
     case div_by_zero:
@@ -144,29 +162,36 @@ void exc_handler(int intr_num){
 }
 
 
-/* void hardware_handler(int intr_num)
+/* void hardware_handler(int intr_num, hw_context_t* regs)
  * inputs: int intr_num - IRQ # for interrupt
+ *         hw_context_t* regs - registers saved by the linkage
  * outputs: void
- * Function: calls the handler function for the given IRQ
+ * Function: calls the handler function (top half) for the given IRQ, then runs the
+ *           raised softirqs and the task switch a PIT tick held back for them
  */
-void hardware_handler(int intr_num){
+void hardware_handler(int intr_num, hw_context_t* regs){
     cli();
+    irq_counts[intr_num - IRQ0]++;
     switch (intr_num)
     {
     case IRQ0: // handle the PIT
         pit_handler();
         break;
     case IRQ1:
-        keyboard_handler();  //handle the keyboard
-        sti();          // start the end of interrupt routine
-        send_eoi(KEYBOARD_IRQ_NUM); //send the end of interrupt signal for IRQ1
+        keyboard_handler();  //queue the scan code and send the EOI
+        break;
+    case IRQ4:
+        serial_handler();   //COM1
+        send_eoi(SERIAL_IRQ_NUM);
         break;
     case IRQ8:
+        prof_tick(regs);    // the RTC also clocks the profiler
         rtc_handler(); //handle the RTC
-        sti();          
         send_eoi(RTC_PIC_PIN); 
         break;
     }
+    do_softirq();   // bottom halves, with interrupts enabled
+    pit_deferred_switch();  // a PIT tick during them switches tasks now
 }
 
 
@@ -4,12 +4,18 @@
 #define IDT_HANDLER_H
 
 #include "types.h"
+#include "signal.h"
 
 
 #define EXEC_STATUS 256
+#define NUM_EXCEPTIONS 20   // vectors 0 to 19 have handlers
+#define NUM_IRQS 16
+
+void exc_handler(int intr_num, hw_context_t* regs);
+void hardware_handler(int intr_num, hw_context_t* regs);
+extern uint32_t exc_counts[NUM_EXCEPTIONS];     // exceptions taken, by vector
+extern uint32_t irq_counts[NUM_IRQS];           // hardware interrupts taken, by IRQ line
 
-void exc_handler(int intr_num);
-void hardware_handler(int intr_num);
 // int32_t sys_call_handler(unsigned int eax, unsigned int ebx, unsigned int ecx, unsigned int edx);
 
 // EXCEPTIONS
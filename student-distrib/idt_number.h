@@ -43,6 +43,9 @@
 
 // SYSTEM CALL (0x80)
 #define SYS_CALL 128
+#define NUM_SYS_CALLS 30    // jump table size, valid numbers are 1 to NUM_SYS_CALLS-1
+#define SIGRETURN_NUM 10    // restores a whole register frame, see signal.c
+#define THREAD_EXIT_NUM 28  // called by the trampoline a thread returns into, see thread.c
 
 
 #endif
@@ -16,6 +16,16 @@
 #include "system_call.h"
 #include "pit.h"
 #include "scheduling.h"
+#include "softirq.h"
+#include "klog.h"
+#include "serial.h"
+#include "clock.h"
+#include "vdso.h"
+#include "timer.h"
+#include "sysenter.h"
+#include "shm.h"
+#include "kthread.h"
+#include "fpu.h"
 
 // #define RUN_TESTS
 
@@ -163,6 +173,13 @@ void entry(unsigned long magic, unsigned long addr) {
     /* Enable the Cursor */
     enable_cursor(0, 15);
 
+    /* Init the deferred work before any handler can raise it */
+    softirq_init();
+    klog_init();
+
+    /* Init COM1, the second console of terminal 0 */
+    serial_init();
+
     /* Init the Keyboard */
     keyboard_init();
 
@@ -172,9 +189,18 @@ void entry(unsigned long magic, unsigned long addr) {
 	process_num = -1;
     shell_process_count = 0;
     first_call = 1;
-    schedule_idx = 0;
+    scheduler_init();
     pit_count = 0;
     process_count = 0;
+    /* Calibrate the TSC clock before the PIT tick starts */
+    clock_init();
+    vdso_init();
+    sysenter_init();
+    fpu_init();
+    shm_init();
+    timer_init();
+    kthread_init();
+
     /* Init the PIT*/
     pit_init();
 
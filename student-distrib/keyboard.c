@@ -9,6 +9,8 @@
 #include "x86_desc.h"
 #include "scheduling.h"
 #include "paging.h"
+#include "softirq.h"
+#include "poll.h"
 
 /* flags for function keys initially set to 0 */
 int32_t terminal_num = 0;
@@ -24,12 +26,19 @@ uint8_t newline_bs_flag = 0;
 int i;
 char printed_char;
 
+/* scan code ring between the IRQ1 top half (producer) and keyboard_bottom_half (consumer) */
+uint8_t scan_ring[SCAN_RING_SIZE];
+volatile uint32_t scan_head = 0;     // written by the bottom half only
+volatile uint32_t scan_tail = 0;     // written by the top half only
+volatile uint32_t scan_dropped = 0;  // scan codes lost to a full ring
+
 
 /* helpers */
 int is_letter(uint8_t scan_code);
 int flag_setters(uint8_t scan_code);
 int is_printable(uint8_t scan_code);
 void space_handler(void);
+void keyboard_process(uint8_t scan_code);
 
 
 
@@ -53,6 +62,7 @@ char shift_scan[0xD8] = {'.', '.', '!', '@', '#', '$', '%', '^', '&', '*', '(',
  * side effects: enables irq pin for keyboard on the PIC
  */
 void keyboard_init(){
+    open_softirq(SOFTIRQ_KEYBOARD, keyboard_bottom_half);
     enable_irq(KEYBOARD_IRQ_NUM);
     int32_t i;
     for(i=0;i<3;i++){
@@ -69,14 +79,58 @@ void keyboard_init(){
 
 
 /* void keyboard_handler()
- * The keyboard interrupt handler
+ * The keyboard interrupt handler (top half)
  * inputs: none
  * outputs: none
- * side effects: prints a character once a key is pressed, re-enables interrupts
+ * side effects: queues the scan code, raises the keyboard softirq and sends the EOI, drops
+ *               the scan code if the ring is full
  */
 void keyboard_handler(){
-    cli();
-    uint32_t scan_code = inb(KEYBOARD_DATA_PORT); //read the scan code from the port
+    uint8_t scan_code = inb(KEYBOARD_DATA_PORT); //read the scan code from the port
+
+    if(scan_tail - scan_head < SCAN_RING_SIZE){
+        scan_ring[scan_tail & (SCAN_RING_SIZE - 1)] = scan_code;
+        barrier();         // slot must be written before the bottom half can see it
+        scan_tail++;
+    }else{
+        scan_dropped++;
+    }
+    raise_softirq(SOFTIRQ_KEYBOARD);
+    send_eoi(KEYBOARD_IRQ_NUM); //send the end of interrupt signal for IRQ1
+}
+
+/* void keyboard_bottom_half()
+ * Keyboard softirq, drains the scan code ring with interrupts enabled
+ * inputs: none
+ * outputs: none
+ * side effects: decodes, echoes and switches terminals for every queued scan code. Scan codes
+ *               queued while it runs raise the softirq again, so do_softirq reruns it.
+ */
+void keyboard_bottom_half(){
+    while(scan_head != scan_tail){
+        keyboard_process(scan_ring[scan_head & (SCAN_RING_SIZE - 1)]);
+        barrier();     // slot must be read before the top half may reuse it
+        scan_head++;
+    }
+    poll_notify();     // a line, a raw event or a terminal switch may make stdin ready
+}
+
+/* void keyboard_process(uint8_t scan_code)
+ * Handles a single scan code
+ * inputs: uint8_t scan_code -- the scan code read by the top half
+ * outputs: none
+ * side effects: prints a character once a key is pressed
+ */
+void keyboard_process(uint8_t scan_code){
+
+    // raw mode: queue the event for the reader, no echo or line editing
+    if(terminal_mode(terminal_num) & TERM_RAW){
+        flag_setters(scan_code);    // keep modifiers in sync for when the terminal leaves raw mode
+        if(!(alt && (scan_code >= F1_SCAN_CODE) && (scan_code <= F3_SCAN_CODE))){  // alt+f1-f3 still switch terminals
+            terminal_raw_push(terminal_num, scan_code);
+            return;
+        }
+    }
     
     //enter
     if(scan_code == ENTER){
@@ -87,13 +141,11 @@ void keyboard_handler(){
         //printf("391OS>");
         newline_bs_flag = 1;    //turn on the newline backsapce flag so backspace doesn't delete past the start of the new line
         row_letter_ct = HEADER_LEN;      //reset the row (391OS> is 6 characters long)
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();              // start the end of interrupt routine
         return;
     }
 
 
-    if((alt)&&(scan_code == 0x3B)){         //upon alt+f1
+    if((alt)&&(scan_code == F1_SCAN_CODE)){         //upon alt+f1
         // if(terminal_num == 0){
         //     sti();          // start the end of interrupt routine
         //     send_eoi(KEYBOARD_IRQ_NUM);
@@ -105,12 +157,10 @@ void keyboard_handler(){
         
         switch_terminals(terminal_num,  0);
 
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();          // start the end of interrupt routine
         return;
     }
     
-    if((alt)&&(scan_code == 0x3C)){         //upon alt+f2
+    if((alt)&&(scan_code == F2_SCAN_CODE)){         //upon alt+f2
         // if(terminal_num == 1){
         //     sti();          // start the end of interrupt routine
         //     send_eoi(KEYBOARD_IRQ_NUM);
@@ -121,12 +171,10 @@ void keyboard_handler(){
         // switch_terminals();
         
         switch_terminals(terminal_num, 1);
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();          // start the end of interrupt routine
         return;
     }
 
-    if((alt)&&(scan_code == 0x3D)){         //upon alt+f3
+    if((alt)&&(scan_code == F3_SCAN_CODE)){         //upon alt+f3
         // if(terminal_num == 2){
         //     sti();          // start the end of interrupt routine
         //     send_eoi(KEYBOARD_IRQ_NUM);
@@ -138,8 +186,17 @@ void keyboard_handler(){
 
         switch_terminals(terminal_num, 2);
 
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();          // start the end of interrupt routine
+        return;
+    }
+
+    //interrupt the program in front of this terminal, the base shell itself is never killed
+    if((ctrl)&&(scan_code == C_SCAN_CODE)){         //upon ctrl + c
+        if(pit_count > terminal_num){               //its shell is running
+            pcb_struct* front = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[terminal_num].curr_pid+1));
+            if(!front->is_base_shell){
+                send_signal(front, SIG_INTERRUPT);
+            }
+        }
         return;
     }
 
@@ -149,8 +206,6 @@ void keyboard_handler(){
         row_letter_ct = HEADER_LEN;      //reset the row (391OS> is 6 characters long)
         //clear_buffer();         
         printf("391OS> ");
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();          // start the end of interrupt routine
         return;
         
     }
@@ -176,16 +231,12 @@ void keyboard_handler(){
 
    // set flags
     if(flag_setters(scan_code)){        //if a flag was set
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();              // start the end of interrupt routine
         return;
     }
 
     //backspace
     if(scan_code == BACKSPACE){
         if(ctrl || alt){
-            send_eoi(KEYBOARD_IRQ_NUM);
-            sti();          // start the end of interrupt routine
             return;
         }
         if(terminal[terminal_num].buffer_ct != 0){         //if there's anything in the buffer
@@ -209,8 +260,6 @@ void keyboard_handler(){
                 terminal[terminal_num].keyboard_buffer[terminal[terminal_num].buffer_ct] = NULL;  //replace that char by null
             }
         }
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();              // start the end of interrupt routine
         return;
     }
 
@@ -218,8 +267,6 @@ void keyboard_handler(){
     //spacebar
     if(scan_code == SPACEBAR){
         if(ctrl || alt || (terminal[terminal_num].buffer_ct == BUFFER_LIM -1)){ //if ctrl or alt are pressed or the buffer is full
-            send_eoi(KEYBOARD_IRQ_NUM);
-            sti();          // start the end of interrupt routine
             return;
         }
         space_handler();        // print a space
@@ -227,8 +274,6 @@ void keyboard_handler(){
             terminal[terminal_num].keyboard_buffer[terminal[terminal_num].buffer_ct] = ' ';
             terminal[terminal_num].buffer_ct++;
         }
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();              // start the end of interrupt routine
         return;
     }
 
@@ -237,8 +282,6 @@ void keyboard_handler(){
     //tab
     if(scan_code == TAB){
         if(ctrl || alt || (terminal[terminal_num].buffer_ct == BUFFER_LIM -1)){
-            send_eoi(KEYBOARD_IRQ_NUM);
-            sti();              // start the end of interrupt routines
             return;
         }
         if(terminal[terminal_num].buffer_ct < (BUFFER_LIM - 1)){       // fill the buffer accordingly
@@ -255,16 +298,12 @@ void keyboard_handler(){
         // else{
         //     row_letter_ct += 4;     //increment row char ct by 4
         // }
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();              // start the end of interrupt routine
         return;
     }
 
     //single quote
     if(scan_code == SINGLE_QUOTE_SCAN_CODE){
         if(ctrl || alt || (terminal[terminal_num].buffer_ct == BUFFER_LIM - 1)){
-            send_eoi(KEYBOARD_IRQ_NUM);
-            sti();          // start the end of interrupt routine
             return;
         }
         if (row_letter_ct == ROW_LIM){      //newline if you're end of the line
@@ -287,16 +326,12 @@ void keyboard_handler(){
             }
         }
         row_letter_ct++;
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();              // start the end of interrupt routine
         return;
     }
 
     //back tick
     if(scan_code == BACK_TICK_SCAN_CODE){
         if(ctrl || alt || (terminal[terminal_num].buffer_ct == BUFFER_LIM - 1)){
-            send_eoi(KEYBOARD_IRQ_NUM);
-            sti();          // start the end of interrupt routine
             return;
         }
         if (row_letter_ct == ROW_LIM){      //newline if you're end of the line
@@ -319,16 +354,12 @@ void keyboard_handler(){
             }   
         }
         row_letter_ct++;
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();          // start the end of interrupt routine
         return;
     }
 
     //backslash
     if(scan_code == BACKSLASH_SCAN_CODE){
         if(ctrl || alt || (terminal[terminal_num].buffer_ct == BUFFER_LIM - 1)){
-            send_eoi(KEYBOARD_IRQ_NUM);
-            sti();      // start the end of interrupt routine
             return;
         }
         if (row_letter_ct == ROW_LIM){          //newline if you're end of the line
@@ -351,8 +382,6 @@ void keyboard_handler(){
             }
         }
         row_letter_ct++;
-        send_eoi(KEYBOARD_IRQ_NUM);
-        sti();          // start the end of interrupt routine
         return;
     }
 
@@ -360,8 +389,6 @@ void keyboard_handler(){
     
     if(is_printable(scan_code)){  //check the scan code boundaries
         if(ctrl || alt || (terminal[terminal_num].buffer_ct == BUFFER_LIM - 1)){
-            send_eoi(KEYBOARD_IRQ_NUM);
-            sti();      // start the end of interrupt routine
             return;
         }
 
@@ -402,8 +429,6 @@ void keyboard_handler(){
 
 
 
-    send_eoi(KEYBOARD_IRQ_NUM); //send the end of interrupt signal for IRQ1
-    sti();          // start the end of interrupt routine
 }
 
 /* int flag_setters(uint8_t scan_code)
@@ -513,15 +538,15 @@ void space_handler(void){
 
 /* void clear_buffer()
  * Clear the pending buffer
- * inputs: none
+ * inputs: int32_t term -- terminal index
  * outputs: none
- * side effects: fills up terminal[terminal_num].keyboard_buffer with NULLs
+ * side effects: fills up terminal[term].keyboard_buffer with NULLs
  */
-void clear_buffer(){
+void clear_buffer(int32_t term){
     for(i=0; i<(BUFFER_LIM - 1); i++){ // for (BUFFER_LIM - 1) chars
-        terminal[terminal_num].keyboard_buffer[i] = NULL;  // fill it up with NULLs
+        terminal[term].keyboard_buffer[i] = NULL;  // fill it up with NULLs
     }
-    terminal[terminal_num].buffer_ct = 0;  //reset the counter
+    terminal[term].buffer_ct = 0;  //reset the counter
 }
 
 /* void switch_terminals()
@@ -532,11 +557,14 @@ void clear_buffer(){
  * side effects: copies current video screen of terminal to terminal video memory and copies terminal video memory to current video screen
  */
 void switch_terminals(int32_t previous_terminal_num, int32_t next_terminal_num){
+    uint32_t flags;
+    cli_and_save(flags);    // the scheduler must not see half swapped video pages
     switch_video_mem(previous_terminal_num, next_terminal_num);
     // save current terminal screen to video page assigned for it
     memcpy((void*)(VIDEO + (previous_terminal_num+1)*FOUR_KB), (const void*)(VIDEO), (uint32_t)FOUR_KB);
     memcpy((void*)(VIDEO), (const void*)(VIDEO + (next_terminal_num+1)*FOUR_KB), (uint32_t)FOUR_KB);
     terminal_num = next_terminal_num; // update terminal_num
+    restore_flags(flags);
 }
 
 
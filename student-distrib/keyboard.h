@@ -29,12 +29,16 @@
 
 #define P_SCAN_CODE 0x19
 #define L_SCAN_CODE 0x26
+#define C_SCAN_CODE 0x2E
 #define Z_SCAN_CODE 0x2C
 #define M_SCAN_CODE 0x32
 #define W_SCAN_CODE 0x11
 #define SINGLE_QUOTE_SCAN_CODE 0x28
 #define BACK_TICK_SCAN_CODE 0x29
 #define BACKSLASH_SCAN_CODE 0x2B
+#define F1_SCAN_CODE 0x3B
+#define F2_SCAN_CODE 0x3C
+#define F3_SCAN_CODE 0x3D
 
 #define L_SHIFT_ON  0x2A
 #define L_SHIFT_OFF 0xAA
@@ -59,9 +63,14 @@
 #define BUFFER_LIM 128
 #define HEADER_LEN 7
 
+#define SCAN_RING_SIZE 128   // scan codes buffered between top and bottom half, power of 2
+
+extern volatile uint32_t scan_dropped;  // scan codes lost to a full ring
+
 void keyboard_handler(void);
+void keyboard_bottom_half(void);
 void keyboard_init(void);
-void clear_buffer();
+void clear_buffer(int32_t term);
 void switch_terminals(int32_t previous_terminal_num, int32_t next_terminal_num);
 // void vidmap_terminal();
 uint32_t saved_esp[3];
@@ -0,0 +1,262 @@
+/* klog.c - kernel log ring buffer
+ * klog() formats a message into a record of a fixed ring and returns without touching any
+ * device. Writers claim a sequence number with one atomic add, so the ring needs no lock and
+ * can be written from interrupt handlers. A job on the kworker thread writes new records to
+ * the sinks (the console, later other devices) a batch at a time, so slow sinks never run in
+ * interrupt context, and the ring can be read back through the virtual file "klog".
+ */
+
+#include "klog.h"
+#include "lib.h"
+#include "kthread.h"
+#include "system_call.h"
+#include "scheduling.h"
+#include "timer.h"
+#include "thread.h"
+
+static klog_record_t klog_ring[KLOG_SLOTS];
+static volatile uint32_t klog_head = 0;        // next sequence number to claim
+static uint32_t klog_drained = 0;              // next sequence number for the sinks
+uint32_t klog_lost = 0;                        // records overwritten before the sinks saw them
+
+static klog_sink_t sinks[KLOG_MAX_SINKS];
+static uint32_t sink_levels[KLOG_MAX_SINKS];
+static uint32_t num_sinks = 0;
+
+static const int8_t level_tag[] = "EWID";
+static tasklet_t klog_work;                    // klog_drain on the kworker thread
+
+fop_table_t klog_fop = {
+    klog_open,
+    klog_close,
+    klog_read,
+    klog_write
+};
+
+void klog_drain(uint32_t data);
+
+/* uint32_t klog_claim(void)
+ * Inputs: none
+ * Return Value: the claimed sequence number
+ * Function: atomically increments klog_head */
+static inline uint32_t klog_claim(void){
+    uint32_t seq = 1;
+    asm volatile ("lock xaddl %0, %1"
+                    : "+r"(seq), "+m"(klog_head)
+                    :
+                    : "memory", "cc"
+                    );
+    return seq;
+}
+
+/* void console_sink(const int8_t* text, uint32_t len)
+ * Inputs: const int8_t* text -- message
+ *         uint32_t len -- its length
+ * Return Value: none
+ * Function: writes a record to the visible screen */
+static void console_sink(const int8_t* text, uint32_t len){
+    vga_write(text, len);       // the serial sink has its own copy
+    vga_putc('\n');
+}
+
+/* void klog_init(void)
+ * Inputs: none
+ * Return Value: none
+ * Function: empties the ring and installs the console sink */
+void klog_init(void){
+    memset(klog_ring, 0, sizeof(klog_ring));
+    klog_head = 0;
+    klog_drained = 0;
+    klog_lost = 0;
+    num_sinks = 0;
+    klog_work.func = klog_drain;
+    klog_work.data = 0;
+    klog_work.scheduled = 0;
+    klog_add_sink(console_sink, KLOG_CONSOLE_LEVEL);
+}
+
+/* int32_t klog_add_sink(klog_sink_t sink, uint32_t max_level)
+ * Inputs: klog_sink_t sink -- function called with each new record
+ *         uint32_t max_level -- least severe level the sink wants
+ * Return Value: 0 on success, -1 if all sink slots are used
+ * Function: adds an output for the kernel log, records already drained are not replayed */
+int32_t klog_add_sink(klog_sink_t sink, uint32_t max_level){
+    uint32_t flags;
+    if(sink == NULL || num_sinks >= KLOG_MAX_SINKS) return -1;
+    cli_and_save(flags);
+    sinks[num_sinks] = sink;
+    sink_levels[num_sinks] = max_level;
+    num_sinks++;
+    restore_flags(flags);
+    return 0;
+}
+
+/* int32_t klog(uint32_t level, int8_t* format, ...)
+ * Inputs: uint32_t level -- KLOG_ERR to KLOG_DEBUG
+ *         int8_t* format -- printf style format, see vsnprintf
+ * Return Value: number of characters logged
+ * Function: appends a record to the ring and queues the klog job. Never waits on a
+ *           device, safe in interrupt handlers and with interrupts disabled. */
+int32_t klog(uint32_t level, int8_t* format, ...){
+    int8_t text[KLOG_MSG_LEN + 1];      // vsnprintf adds a NUL the record has no room for
+    klog_record_t* rec;
+    uint32_t seq, len;
+    va_list ap;
+
+    va_start(ap, format);
+    len = vsnprintf(text, sizeof(text), format, ap);
+    va_end(ap);
+    if(len > KLOG_MSG_LEN) len = KLOG_MSG_LEN;
+    while(len > 0 && text[len-1] == '\n'){    // records are lines already
+        len--;
+    }
+
+    seq = klog_claim();
+    rec = &klog_ring[seq & (KLOG_SLOTS - 1)];
+    rec->seq = 0;                       // readers skip the slot until it is complete
+    barrier();
+    memcpy(rec->text, text, len);
+    rec->level = (level > KLOG_DEBUG) ? KLOG_DEBUG : level;
+    rec->len = len;
+    barrier();
+    rec->seq = seq + 1;
+
+    kworker_queue(&klog_work);
+    return len;
+}
+
+/* int32_t klog_copy(uint32_t seq, klog_record_t* out)
+ * Inputs: uint32_t seq -- sequence number
+ *         klog_record_t* out -- copy of the record
+ * Return Value: 0 if the record was copied, -1 if it is not complete or was overwritten
+ * Function: takes a consistent copy of a record */
+static int32_t klog_copy(uint32_t seq, klog_record_t* out){
+    klog_record_t* rec = &klog_ring[seq & (KLOG_SLOTS - 1)];
+    if(rec->seq != seq + 1) return -1;
+    barrier();
+    memcpy(out, rec, sizeof(klog_record_t));
+    barrier();
+    if(rec->seq != seq + 1) return -1;  // a writer reused the slot while we copied
+    return 0;
+}
+
+/* void klog_drain(uint32_t data)
+ * Inputs: uint32_t data -- unused
+ * Return Value: none
+ * Function: kworker job, writes up to KLOG_BATCH new records to the sinks and queues itself
+ *           again if more are left */
+void klog_drain(uint32_t data){
+    klog_record_t rec;
+    uint32_t batch, s;
+
+    for(batch = 0; batch < KLOG_BATCH && klog_drained != klog_head; batch++){
+        if(klog_head - klog_drained > KLOG_SLOTS){     // writers lapped the sinks
+            klog_lost += klog_head - klog_drained - KLOG_SLOTS;
+            klog_drained = klog_head - KLOG_SLOTS;
+        }
+        if(klog_copy(klog_drained, &rec) == -1){
+            if(klog_ring[klog_drained & (KLOG_SLOTS - 1)].seq == 0){
+                return;                 // still being written, its writer queues the job again
+            }
+            klog_lost++;                // overwritten while we looked
+            klog_drained++;
+            continue;
+        }
+        for(s = 0; s < num_sinks; s++){
+            if(rec.level <= sink_levels[s]){
+                sinks[s](rec.text, rec.len);
+            }
+        }
+        klog_drained++;
+    }
+    if(klog_drained != klog_head){
+        kworker_queue(&klog_work);
+    }
+}
+
+/* void klog_flush(void)
+ * Inputs: none
+ * Return Value: none
+ * Function: writes every pending record to the sinks now, for use before a halt */
+void klog_flush(void){
+    while(klog_drained != klog_head){
+        klog_drain(0);
+    }
+}
+
+/* int32_t klog_open(const uint8_t* filename)
+ * Inputs: const uint8_t* filename -- "klog"
+ * Return Value: file descriptor, -1 if none is free
+ * Function: opens the log for reading from the oldest record still in the ring */
+int32_t klog_open(const uint8_t* filename){
+    uint32_t oldest = (klog_head > KLOG_SLOTS) ? klog_head - KLOG_SLOTS : 0;
+    return alloc_fd(&klog_fop, 0, oldest);
+}
+
+/* int32_t klog_close(int32_t fd)
+ * Inputs: int32_t fd -- file descriptor
+ * Return Value: 0
+ * Function: releases the descriptor */
+int32_t klog_close(int32_t fd){
+    pcb_struct* pcb = files_pcb();
+    pcb->file_descriptor[fd].flags = 0;
+    return 0;
+}
+
+/* int32_t klog_read(int32_t fd, void* buf, int32_t nbytes)
+ * Inputs: int32_t fd -- file descriptor
+ *         void* buf -- user buffer
+ *         int32_t nbytes -- its size
+ * Return Value: bytes read, 0 once every record has been read or if nbytes is not positive,
+ *               -1 if the next record does not fit in the buffer
+ * Function: copies whole records as "<level> text" lines. The file position is the sequence
+ *           number of the next record, records overwritten before they are read are skipped.
+ *           A record is only used up once all of it has been copied out. */
+int32_t klog_read(int32_t fd, void* buf, int32_t nbytes){
+    pcb_struct* pcb = files_pcb();
+    uint32_t seq = pcb->file_descriptor[fd].file_position;
+    uint8_t* out = (uint8_t*)buf;
+    int32_t count = 0;
+    uint32_t line_len;
+    klog_record_t rec;
+
+    if(nbytes <= 0){
+        return 0;
+    }
+    while(seq != klog_head){
+        if(klog_head - seq > KLOG_SLOTS){
+            seq = klog_head - KLOG_SLOTS;
+        }
+        if(klog_copy(seq, &rec) == -1){
+            if(klog_ring[seq & (KLOG_SLOTS - 1)].seq == 0) break;   // not complete yet
+            seq++;
+            continue;
+        }
+        line_len = rec.len + 3;         // tag, space and newline
+        if(count + line_len > nbytes){
+            if(count == 0){             // buffer smaller than one line, the record stays
+                pcb->file_descriptor[fd].file_position = seq;
+                return -1;
+            }
+            break;
+        }
+        out[count] = level_tag[rec.level];
+        out[count+1] = ' ';
+        memcpy(&out[count+2], rec.text, rec.len);
+        out[count + rec.len + 2] = '\n';
+        count += line_len;
+        seq++;
+    }
+    pcb->file_descriptor[fd].file_position = seq;
+    return count;
+}
+
+/* int32_t klog_write(int32_t fd, const void* buf, int32_t nbytes)
+ * Inputs: int32_t fd -- file descriptor
+ *         const void* buf -- ignored
+ *         int32_t nbytes -- ignored
+ * Return Value: -1
+ * Function: the log is read-only from user space */
+int32_t klog_write(int32_t fd, const void* buf, int32_t nbytes){
+    return -1;
+}
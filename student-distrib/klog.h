@@ -0,0 +1,40 @@
+/* klog.h - kernel log ring buffer */
+
+#ifndef _KLOG_H
+#define _KLOG_H
+
+#include "types.h"
+
+/* log levels, a lower number is more severe */
+#define KLOG_ERR        0
+#define KLOG_WARN       1
+#define KLOG_INFO       2
+#define KLOG_DEBUG      3
+
+#define KLOG_SLOTS      64      // records kept, must be a power of two
+#define KLOG_MSG_LEN    80      // bytes of text per record, longer messages are cut
+#define KLOG_BATCH      8       // records written to the sinks per kworker job
+#define KLOG_MAX_SINKS  4
+#define KLOG_CONSOLE_LEVEL  KLOG_INFO
+
+typedef void (*klog_sink_t)(const int8_t* text, uint32_t len);
+
+typedef struct klog_record_t {
+    volatile uint32_t seq;      // sequence number + 1 once the record is complete, 0 while written
+    uint32_t level;
+    uint32_t len;
+    int8_t text[KLOG_MSG_LEN];
+} klog_record_t;
+
+void klog_init(void);
+int32_t klog(uint32_t level, int8_t* format, ...);
+int32_t klog_add_sink(klog_sink_t sink, uint32_t max_level);
+void klog_flush(void);
+
+/* virtual file "klog" */
+int32_t klog_open(const uint8_t* filename);
+int32_t klog_close(int32_t fd);
+int32_t klog_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t klog_write(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif /* _KLOG_H */
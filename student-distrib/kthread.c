@@ -0,0 +1,163 @@
+/* kthread.c: kernel threads
+ * A kernel thread is a PCB and kernel stack like a process, with no program behind it. It
+ * runs from one of the KTHREAD_SLOTS schedule slots, so scheduler() switches to and from it
+ * like any other process, and never leaves ring 0. kthread_create only fills the PCB, the
+ * scheduler enters the thread function on the empty stack on the thread's first turn.
+ * The kworker thread runs jobs queued with kworker_queue (tasklets, run in order with
+ * interrupts enabled), for work that is too slow for a handler or a system call.
+ */
+
+#include "kthread.h"
+#include "lib.h"
+#include "system_call.h"
+#include "scheduling.h"
+#include "timer.h"
+#include "fpu.h"
+
+static tasklet_t* kworker_head;             // job queue, FIFO
+static tasklet_t* kworker_tail;
+static wait_queue_t kworker_wait;           // the kworker sleeps here while the queue is empty
+
+static void kworker(uint32_t data);
+
+/* void kthread_init(void)
+ * inputs: none
+ * outputs: none
+ * Function: starts the kworker thread, which runs from the first time the shells are up
+ */
+void kthread_init(void){
+    kworker_head = NULL;
+    kworker_tail = NULL;
+    kworker_wait.head = NULL;
+    kthread_create(kworker, 0, (const int8_t*)"kworker");
+}
+
+/* int32_t kthread_create(kthread_fn_t fn, uint32_t data, const int8_t* name)
+ * inputs: fn -- thread function, the thread exits when it returns
+ *         data -- argument for fn
+ *         name -- name of the thread, also shown in place of the program arguments
+ * outputs: pid of the thread, -1 if no PCB or kernel thread slot is free
+ * Function: creates a kernel thread, runnable from the next PIT tick. The pids of the three
+ *           terminal shells are never used, they are taken in order at boot.
+ */
+int32_t kthread_create(kthread_fn_t fn, uint32_t data, const int8_t* name){
+    pcb_struct* pcb;
+    uint32_t flags;
+    int32_t pid, slot;
+
+    cli_and_save(flags);
+    slot = alloc_kthread_slot();
+    if(slot == -1){
+        restore_flags(flags);
+        return FAIL_NEG_ONE;
+    }
+    for(pid = PROCESS_NUMBER_PIT; pid < MAX_PCB; pid++){
+        if(!((pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1)))->active){
+            break;
+        }
+    }
+    if(pid == MAX_PCB){
+        restore_flags(flags);
+        return FAIL_NEG_ONE;
+    }
+
+    pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1));
+    memset(pcb, 0, sizeof(pcb_struct));
+    fpu_release(pcb);
+    pcb->pid = pid;
+    pcb->parent_id = -1;
+    pcb->active = 1;
+    pcb->entry_point = (uint32_t)fn;
+    pcb->kthread = 1;
+    pcb->kthread_data = data;
+    pcb->terminal_num = 0;
+    pcb->state = PROC_RUNNABLE;
+    pcb->slot = slot;
+    pcb->fresh = 1;
+    strncpy((int8_t*)pcb->args, name, ARGS_LEN - 1);
+    pcb->args[ARGS_LEN - 1] = '\0';
+    strncpy((int8_t*)pcb->name, name, DENTRY_FILE_NAME_LEN);
+    schedule_array[slot] = pid;
+    restore_flags(flags);
+    return pid;
+}
+
+/* void kthread_start(void)
+ * inputs: none
+ * outputs: does not return
+ * Function: first code a kernel thread runs, called by the scheduler on the empty stack of
+ *           the thread with interrupts disabled
+ */
+void kthread_start(void){
+    pcb_struct* pcb = current_pcb();
+
+    sti();
+    ((kthread_fn_t)pcb->entry_point)(pcb->kthread_data);
+    kthread_exit();
+}
+
+/* void kthread_exit(void)
+ * inputs: none
+ * outputs: does not return
+ * Function: ends the running kernel thread. Like halt_spawned it frees the slot and pid and
+ *           switches to the next task through schedule_exit, the scheduler never comes back.
+ */
+void kthread_exit(void){
+    pcb_struct* pcb = current_pcb();
+
+    cli();
+    fpu_release(pcb);
+    schedule_array[pcb->slot] = SLOT_FREE;
+    pcb->kthread = 0;
+    pcb->active = 0;
+    schedule_exit();
+}
+
+/* void kworker_queue(tasklet_t* work)
+ * inputs: work -- job, func and data filled in by the caller
+ * outputs: none
+ * Function: queues a job for the kworker thread, does nothing if it is already queued. Safe
+ *           to call from interrupt handlers, and before the kworker first runs.
+ */
+void kworker_queue(tasklet_t* work){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    if(!work->scheduled){
+        work->scheduled = 1;
+        work->next = NULL;
+        if(kworker_tail == NULL){
+            kworker_head = work;
+        }else{
+            kworker_tail->next = work;
+        }
+        kworker_tail = work;
+        wake_up(&kworker_wait);
+    }
+    restore_flags(flags);
+}
+
+/* void kworker(uint32_t data)
+ * inputs: data -- unused
+ * outputs: none
+ * Function: kworker thread, runs queued jobs and sleeps while there are none. A job is
+ *           marked unqueued before it runs so it can queue itself again.
+ */
+static void kworker(uint32_t data){
+    tasklet_t* work;
+
+    while(1){
+        cli();
+        while(kworker_head == NULL){
+            wait_event(&kworker_wait, TIMER_NO_DEADLINE);
+        }
+        work = kworker_head;
+        kworker_head = work->next;
+        if(kworker_head == NULL){
+            kworker_tail = NULL;
+        }
+        work->scheduled = 0;
+        sti();
+        work->func(work->data);
+    }
+}
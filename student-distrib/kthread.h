@@ -0,0 +1,17 @@
+/* kthread.h: kernel threads and the kworker thread that runs deferred jobs */
+
+#ifndef _KTHREAD_H
+#define _KTHREAD_H
+
+#include "types.h"
+#include "softirq.h"
+
+typedef void (*kthread_fn_t)(uint32_t data);
+
+void kthread_init(void);
+int32_t kthread_create(kthread_fn_t fn, uint32_t data, const int8_t* name);
+void kthread_start(void);
+void kthread_exit(void);
+void kworker_queue(tasklet_t* work);
+
+#endif /* _KTHREAD_H */
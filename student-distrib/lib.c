@@ -3,6 +3,8 @@
 
 #include "lib.h"
 #include "filesys.h"
+#include "serial.h"
+#include "fpu.h"
 
 #define VIDEO       0xB8000
 #define FOUR_KB     4096
@@ -10,6 +12,14 @@
 #define NUM_ROWS    25
 #define ATTRIB      0x7
 
+#define SSE_MIN_BYTES   512     // memcpy and memset hand larger blocks to SSE2
+#define SSE_ALIGN       16
+#define SSE_BLOCK       64      // bytes per loop iteration, four xmm registers
+#define WORD_MASK       (sizeof(uint32_t) - 1)
+#define ONES            0x01010101
+#define HIGHS           0x80808080
+#define HAS_ZERO_BYTE(w)    (((w) - ONES) & ~(w) & HIGHS)
+
 int i;
 static int screen_x;
 static int screen_y;
@@ -20,12 +30,16 @@ extern uint8_t row_letter_ct;
 int save_x[3] = {0, 0, 0};
 int save_y[3] = {0, 0, 0};
 
+static void vga_emit(uint8_t c);
+
 /* void clear(void);
  * Inputs: void
  * Return Value: none
  * Function: Clears video memory */
 void clear(void) {
     int32_t i;
+    uint32_t flags;
+    cli_and_save(flags);    // keyboard echo runs with interrupts enabled
     for (i = 0; i < NUM_ROWS * NUM_COLS; i++) {
         *(uint8_t *)(VIDEO + (i << 1)) = ' ';
         *(uint8_t *)(VIDEO + (i << 1) + 1) = ATTRIB;
@@ -33,10 +47,11 @@ void clear(void) {
     screen_x = 0;
     screen_y = 0;
     update_cursor(screen_x, screen_y);
+    restore_flags(flags);
 }
 
 
-/* Standard printf().
+/* Conversions shared by printf, snprintf and vsnprintf.
  * Only supports the following format strings:
  * %%  - print a literal '%' character
  * %x  - print a number in hexadecimal
@@ -52,114 +67,218 @@ void clear(void) {
  *       for the "#" modifier (this implementation doesn't add a "0x" at
  *       the beginning), but I think it's more flexible this way.
  *       Also note: %x is the only conversion specifier that can use
- *       the "#" modifier to alter output. */
-int32_t printf(int8_t *format, ...) {
+ *       the "#" modifier to alter output.
+ * A decimal field width may come before the conversion, e.g. %4d or %-12s, and a leading
+ * '0' pads numbers with zeros instead of spaces. */
+
+#define PRINTF_BUF_SIZE 128     // bytes printf formats before each console write
+#define HEX_WIDTH       8       // digits printed by %#x
+
+/* Output of the formatter: a buffer, and for printf a function that empties it when full */
+typedef struct fmt_out_t {
+    int8_t* buf;
+    uint32_t size;                  // usable bytes, not counting a terminating NUL
+    uint32_t len;                   // bytes in buf
+    uint32_t total;                 // bytes the whole format produces
+    int32_t (*flush)(const int8_t* buf, uint32_t n);
+} fmt_out_t;
+
+/* void fmt_putc(fmt_out_t* out, int8_t c);
+ * Inputs: fmt_out_t* out = output
+ *               int8_t c = character to add
+ * Return Value: none
+ * Function: appends c to the buffer, flushing it first if it is full. Without a flush
+ *           function characters past the end are only counted */
+static void fmt_putc(fmt_out_t* out, int8_t c) {
+    if (out->len == out->size && out->flush != NULL) {
+        out->flush(out->buf, out->len);
+        out->len = 0;
+    }
+    if (out->len < out->size)
+        out->buf[out->len++] = c;
+    out->total++;
+}
 
-    /* Pointer to the format string */
-    int8_t* buf = format;
+/* void fmt_field(fmt_out_t* out, const int8_t* s, uint32_t width, int32_t left, int8_t pad);
+ * Inputs: fmt_out_t* out = output
+ *         const int8_t* s = converted text
+ *         uint32_t width = minimum field width
+ *         int32_t left = nonzero to pad on the right
+ *         int8_t pad = ' ' or '0'
+ * Return Value: none
+ * Function: appends s padded out to width. Zero padding goes after a leading '-' */
+static void fmt_field(fmt_out_t* out, const int8_t* s, uint32_t width, int32_t left, int8_t pad) {
+    uint32_t len = strlen(s);
+
+    if (pad == '0' && *s == '-') {
+        fmt_putc(out, *s++);
+        width = (width > 0) ? width - 1 : 0;
+        len--;
+    }
+    for (; !left && width > len; width--)
+        fmt_putc(out, pad);
+    while (*s != '\0')
+        fmt_putc(out, *s++);
+    for (; left && width > len; width--)
+        fmt_putc(out, ' ');
+}
+
+/* uint32_t fmt_format(fmt_out_t* out, const int8_t* format, va_list ap);
+ * Inputs: fmt_out_t* out = output
+ *         const int8_t* format = format string
+ *         va_list ap = arguments
+ * Return Value: number of characters the format produces
+ * Function: the conversions described above */
+static uint32_t fmt_format(fmt_out_t* out, const int8_t* format, va_list ap) {
+    const int8_t* buf = format;
+
+    for (; *buf != '\0'; buf++) {
+        int8_t conv_buf[36];
+        int32_t alternate = 0;
+        int32_t left = 0;
+        int8_t pad = ' ';
+        uint32_t width = 0;
+
+        if (*buf != '%') {
+            fmt_putc(out, *buf);
+            continue;
+        }
+        buf++;
 
-    /* Stack pointer for the other parameters */
-    int32_t* esp = (void *)&format;
-    esp++;
+        /* Flags and field width */
+        for (;; buf++) {
+            if (*buf == '#') alternate = 1;
+            else if (*buf == '-') left = 1;
+            else if (*buf == '0') pad = '0';
+            else break;
+        }
+        for (; *buf >= '0' && *buf <= '9'; buf++)
+            width = width * 10 + (*buf - '0');
+        if (left) pad = ' ';
 
-    while (*buf != '\0') {
+        /* Conversion specifiers */
         switch (*buf) {
+            /* Print a literal '%' character */
             case '%':
+                fmt_putc(out, '%');
+                break;
+
+            /* Print a number in hexadecimal form */
+            case 'x':
+                if (alternate) {
+                    width = HEX_WIDTH;
+                    pad = '0';
+                    left = 0;
+                }
+                itoa(va_arg(ap, uint32_t), conv_buf, 16);
+                fmt_field(out, conv_buf, width, left, pad);
+                break;
+
+            /* Print a number in unsigned int form */
+            case 'u':
+                itoa(va_arg(ap, uint32_t), conv_buf, 10);
+                fmt_field(out, conv_buf, width, left, pad);
+                break;
+
+            /* Print a number in signed int form */
+            case 'd':
                 {
-                    int32_t alternate = 0;
-                    buf++;
-
-format_char_switch:
-                    /* Conversion specifiers */
-                    switch (*buf) {
-                        /* Print a literal '%' character */
-                        case '%':
-                            putc('%');
-                            break;
-
-                        /* Use alternate formatting */
-                        case '#':
-                            alternate = 1;
-                            buf++;
-                            /* Yes, I know gotos are bad.  This is the
-                             * most elegant and general way to do this,
-                             * IMHO. */
-                            goto format_char_switch;
-
-                        /* Print a number in hexadecimal form */
-                        case 'x':
-                            {
-                                int8_t conv_buf[64];
-                                if (alternate == 0) {
-                                    itoa(*((uint32_t *)esp), conv_buf, 16);
-                                    puts(conv_buf);
-                                } else {
-                                    int32_t starting_index;
-                                    int32_t i;
-                                    itoa(*((uint32_t *)esp), &conv_buf[8], 16);
-                                    i = starting_index = strlen(&conv_buf[8]);
-                                    while(i < 8) {
-                                        conv_buf[i] = '0';
-                                        i++;
-                                    }
-                                    puts(&conv_buf[starting_index]);
-                                }
-                                esp++;
-                            }
-                            break;
-
-                        /* Print a number in unsigned int form */
-                        case 'u':
-                            {
-                                int8_t conv_buf[36];
-                                itoa(*((uint32_t *)esp), conv_buf, 10);
-                                puts(conv_buf);
-                                esp++;
-                            }
-                            break;
-
-                        /* Print a number in signed int form */
-                        case 'd':
-                            {
-                                int8_t conv_buf[36];
-                                int32_t value = *((int32_t *)esp);
-                                if(value < 0) {
-                                    conv_buf[0] = '-';
-                                    itoa(-value, &conv_buf[1], 10);
-                                } else {
-                                    itoa(value, conv_buf, 10);
-                                }
-                                puts(conv_buf);
-                                esp++;
-                            }
-                            break;
-
-                        /* Print a single character */
-                        case 'c':
-                            putc((uint8_t) *((int32_t *)esp));
-                            esp++;
-                            break;
-
-                        /* Print a NULL-terminated string */
-                        case 's':
-                            puts(*((int8_t **)esp));
-                            esp++;
-                            break;
-
-                        default:
-                            break;
+                    int32_t value = va_arg(ap, int32_t);
+                    if (value < 0) {
+                        conv_buf[0] = '-';
+                        itoa(-value, &conv_buf[1], 10);
+                    } else {
+                        itoa(value, conv_buf, 10);
                     }
+                    fmt_field(out, conv_buf, width, left, pad);
+                }
+                break;
+
+            /* Print a single character */
+            case 'c':
+                conv_buf[0] = (int8_t)va_arg(ap, int32_t);
+                conv_buf[1] = '\0';
+                fmt_field(out, conv_buf, width, left, ' ');
+                break;
 
+            /* Print a NULL-terminated string */
+            case 's':
+                {
+                    const int8_t* str = va_arg(ap, const int8_t*);
+                    fmt_field(out, (str != NULL) ? str : "(null)", width, left, ' ');
                 }
                 break;
 
+            /* A '%' at the very end prints nothing */
+            case '\0':
+                buf--;
+                break;
+
             default:
-                putc(*buf);
                 break;
         }
-        buf++;
     }
-    return (buf - format);
+    return out->total;
+}
+
+/* int32_t vsnprintf(int8_t* buf, uint32_t size, const int8_t* format, va_list ap);
+ * Inputs: int8_t* buf = buffer for the output
+ *         uint32_t size = size of buf, including room for the terminating NUL
+ *         const int8_t* format = format string, as for printf
+ *         va_list ap = arguments
+ * Return Value: number of characters the whole format produces, not counting the NUL. A
+ *               value of size or more means the output was cut short
+ * Function: formats into buf, always NUL terminating it when size is nonzero */
+int32_t vsnprintf(int8_t* buf, uint32_t size, const int8_t* format, va_list ap) {
+    fmt_out_t out;
+
+    out.buf = buf;
+    out.size = (size > 0) ? size - 1 : 0;
+    out.len = 0;
+    out.total = 0;
+    out.flush = NULL;
+    fmt_format(&out, format, ap);
+    if (size > 0)
+        buf[out.len] = '\0';
+    return out.total;
+}
+
+/* int32_t snprintf(int8_t* buf, uint32_t size, const int8_t* format, ...);
+ * Inputs: int8_t* buf = buffer for the output
+ *         uint32_t size = size of buf, including room for the terminating NUL
+ *         const int8_t* format = format string, as for printf
+ * Return Value: as for vsnprintf
+ * Function: vsnprintf with the arguments inline */
+int32_t snprintf(int8_t* buf, uint32_t size, const int8_t* format, ...) {
+    va_list ap;
+    int32_t ret;
+
+    va_start(ap, format);
+    ret = vsnprintf(buf, size, format, ap);
+    va_end(ap);
+    return ret;
+}
+
+/* int32_t printf(int8_t *format, ...);
+ * Inputs: int8_t* format = format string, see the conversions above
+ * Return Value: number of characters printed
+ * Function: formats into a buffer on the stack and hands it to the console a buffer at a
+ *           time, so the cursor moves once per write rather than once per character */
+int32_t printf(int8_t *format, ...) {
+    int8_t buf[PRINTF_BUF_SIZE];
+    fmt_out_t out;
+    va_list ap;
+
+    out.buf = buf;
+    out.size = PRINTF_BUF_SIZE;
+    out.len = 0;
+    out.total = 0;
+    out.flush = console_write;
+    va_start(ap, format);
+    fmt_format(&out, format, ap);
+    va_end(ap);
+    console_write(buf, out.len);
+    return out.total;
 }
 
 /* int32_t puts(int8_t* s);
@@ -167,19 +286,70 @@ format_char_switch:
  *   Return Value: Number of bytes written
  *    Function: Output a string to the console */
 int32_t puts(int8_t* s) {
-    register int32_t index = 0;
-    while (s[index] != '\0') {
-        putc(s[index]);
-        index++;
-    }
-    return index;
+    return console_write(s, strlen(s));
 }
 
 /* void putc(uint8_t c);
  * Inputs: uint_8* c = character to print
  * Return Value: void
- *  Function: Output a character to the console */
+ *  Function: Output a character to the console, and to COM1 while the serial terminal is
+ *            on screen */
 void putc(uint8_t c) {
+    vga_putc(c);
+    if(terminal_num == SERIAL_TERMINAL){
+        serial_putc(c);
+    }
+}
+
+/* int32_t console_write(const int8_t* buf, uint32_t n);
+ * Inputs: const int8_t* buf = characters to print
+ *         uint32_t n = how many
+ * Return Value: n
+ *  Function: putc for a whole buffer */
+int32_t console_write(const int8_t* buf, uint32_t n) {
+    uint32_t j;
+
+    vga_write(buf, n);
+    if(terminal_num == SERIAL_TERMINAL){
+        for(j = 0; j < n; j++)
+            serial_putc(buf[j]);
+    }
+    return n;
+}
+
+/* void vga_putc(uint8_t c);
+ * Inputs: uint_8* c = character to print
+ * Return Value: void
+ *  Function: Output a character to the screen only */
+void vga_putc(uint8_t c) {
+    uint32_t flags;
+    cli_and_save(flags);    // screen_x/screen_y are shared with the keyboard bottom half
+    vga_emit(c);
+    update_cursor(screen_x, screen_y);
+    restore_flags(flags);
+}
+
+/* void vga_write(const int8_t* buf, uint32_t n);
+ * Inputs: const int8_t* buf = characters to print
+ *         uint32_t n = how many
+ * Return Value: void
+ *  Function: Output a buffer to the screen only, moving the cursor once at the end */
+void vga_write(const int8_t* buf, uint32_t n) {
+    uint32_t flags;
+    uint32_t j;
+    cli_and_save(flags);
+    for(j = 0; j < n; j++)
+        vga_emit(buf[j]);
+    update_cursor(screen_x, screen_y);
+    restore_flags(flags);
+}
+
+/* void vga_emit(uint8_t c);
+ * Inputs: uint_8* c = character to print
+ * Return Value: void
+ *  Function: puts a character in video memory and advances screen_x/screen_y. The caller
+ *            disables interrupts and updates the cursor */
+static void vga_emit(uint8_t c) {
      video_mem = (char*) VIDEO;
     if (NUM_COLS * screen_y + screen_x >= NUM_COLS * NUM_ROWS)
     {
@@ -192,12 +362,11 @@ void putc(uint8_t c) {
         screen_y = (screen_y + (screen_x / NUM_COLS)) % NUM_ROWS;
         *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1)) = ' ';
         *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1) + 1) = ATTRIB;
-        update_cursor(screen_x, screen_y); 
     }
     else if (c == '\t'){ // if current character is tab
         for(i = 0; i<4; i++){ // insert space four times
             if(row_letter_ct == NUM_COLS){
-                putc('\n');
+                vga_emit('\n');
                 row_letter_ct = 0;
             }
             row_letter_ct++;
@@ -206,21 +375,18 @@ void putc(uint8_t c) {
             screen_y = (screen_y + (screen_x / NUM_COLS)) % NUM_ROWS;
             *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1)) = ' ';
             *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1) + 1) = ATTRIB;
-            update_cursor(screen_x, screen_y);
         }
     }
     else{
     if(c == '\n' || c == '\r') { // if current character is newline
         screen_y++; // move cursor row down by one
         screen_x = 0;
-        update_cursor(screen_x, screen_y);
     } else {
         *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1)) = c;
         *(uint8_t *)(video_mem + ((NUM_COLS * screen_y + screen_x) << 1) + 1) = ATTRIB;
         screen_x++;
         screen_x %= NUM_COLS;
         screen_y = (screen_y + (screen_x / NUM_COLS)) % NUM_ROWS;
-        update_cursor(screen_x, screen_y);
     }
     }
 }
@@ -232,6 +398,11 @@ void putc(uint8_t c) {
 //  * Function: Output a character to a background terminal */
 void background_putc(uint8_t c, uint32_t terminal_idx) {
     //int8_t live_flag;
+    uint32_t flags;
+    cli_and_save(flags);
+    if(terminal_idx == SERIAL_TERMINAL){
+        serial_putc(c);
+    }
     
     video_mem = (char*) (VIDEO + (terminal_idx+1)*FOUR_KB);
     // screen_x = terminal[terminal_idx].save_x;
@@ -273,7 +444,7 @@ void background_putc(uint8_t c, uint32_t terminal_idx) {
         //update_cursor(terminal[terminal_idx].save_x, terminal[terminal_idx].save_y);
     }
     }
-    
+    restore_flags(flags);
 }
 
 /* int8_t* itoa(uint32_t value, int8_t* buf, int32_t radix);
@@ -336,10 +507,36 @@ int8_t* strrev(int8_t* s) {
 /* uint32_t strlen(const int8_t* s);
  * Inputs: const int8_t* s = string to take length of
  * Return Value: length of string s
- * Function: return length of string s */
+ * Function: return length of string s, a word at a time once s is aligned. An aligned word
+ *           never crosses a page, so reading past the NUL within it is safe */
 uint32_t strlen(const int8_t* s) {
-    register uint32_t len = 0;
-    while (s[len] != '\0')
+    const int8_t* p = s;
+    const uint32_t* w;
+
+    for (; ((uint32_t)p & WORD_MASK) != 0; p++) {
+        if (*p == '\0')
+            return p - s;
+    }
+    for (w = (const uint32_t*)p; !HAS_ZERO_BYTE(*w); w++);
+    for (p = (const int8_t*)w; *p != '\0'; p++);
+    return p - s;
+}
+
+/* uint32_t strnlen(const int8_t* s, uint32_t n);
+ * Inputs: const int8_t* s = string to take length of
+ *              uint32_t n = most bytes to look at
+ * Return Value: length of string s, n if there is no NUL in the first n bytes
+ * Function: strlen bounded by n, for names that fill their field without a NUL */
+uint32_t strnlen(const int8_t* s, uint32_t n) {
+    uint32_t len = 0;
+
+    for (; len < n && ((uint32_t)(s + len) & WORD_MASK) != 0; len++) {
+        if (s[len] == '\0')
+            return len;
+    }
+    while (n - len >= sizeof(uint32_t) && !HAS_ZERO_BYTE(*(const uint32_t*)(s + len)))
+        len += sizeof(uint32_t);
+    while (len < n && s[len] != '\0')
         len++;
     return len;
 }
@@ -349,9 +546,12 @@ uint32_t strlen(const int8_t* s) {
  *          int32_t c = value to set memory to
  *         uint32_t n = number of bytes to set
  * Return Value: new string
- * Function: set n consecutive bytes of pointer s to value c */
+ * Function: set n consecutive bytes of pointer s to value c, large blocks with SSE2 when
+ *           the CPU has it */
 void* memset(void* s, int32_t c, uint32_t n) {
     c &= 0xFF;
+    if (n >= SSE_MIN_BYTES && fpu_has_sse2)
+        return memset_sse2(s, c, n);
     asm volatile ("                 \n\
             .memset_top:            \n\
             testl   %%ecx, %%ecx    \n\
@@ -432,8 +632,11 @@ void* memset_dword(void* s, int32_t c, uint32_t n) {
  *         const void* src = source of copy
  *              uint32_t n = number of byets to copy
  * Return Value: pointer to dest
- * Function: copy n bytes of src to dest */
+ * Function: copy n bytes of src to dest, large blocks with SSE2 when the CPU has it. Copies
+ *           forward, so dest may overlap src from below */
 void* memcpy(void* dest, const void* src, uint32_t n) {
+    if (n >= SSE_MIN_BYTES && fpu_has_sse2)
+        return memcpy_sse2(dest, src, n);
     asm volatile ("                 \n\
             .memcpy_top:            \n\
             testl   %%ecx, %%ecx    \n\
@@ -478,27 +681,120 @@ void* memcpy(void* dest, const void* src, uint32_t n) {
  *         const void* src = source of move
  *              uint32_t n = number of byets to move
  * Return Value: pointer to dest
- * Function: move n bytes of src to dest */
+ * Function: move n bytes of src to dest. Unless dest overlaps the end of src this is a
+ *           memcpy, otherwise it copies backwards a dword at a time */
 void* memmove(void* dest, const void* src, uint32_t n) {
+    uint32_t d = (uint32_t)dest;
+    uint32_t s = (uint32_t)src;
+
+    if (d <= s || d >= s + n)
+        return memcpy(dest, src, n);
     asm volatile ("                             \n\
             movw    %%ds, %%dx                  \n\
             movw    %%dx, %%es                  \n\
-            cld                                 \n\
-            cmp     %%edi, %%esi                \n\
-            jae     .memmove_go                 \n\
+            std                                 \n\
             leal    -1(%%esi, %%ecx), %%esi     \n\
             leal    -1(%%edi, %%ecx), %%edi     \n\
-            std                                 \n\
-            .memmove_go:                        \n\
+            movl    %%ecx, %%edx                \n\
+            andl    $0x3, %%ecx                 \n\
             rep     movsb                       \n\
+            subl    $3, %%esi                   \n\
+            subl    $3, %%edi                   \n\
+            movl    %%edx, %%ecx                \n\
+            shrl    $2, %%ecx                   \n\
+            rep     movsl                       \n\
+            cld                                 \n\
             "
+            : "+D"(d), "+S"(s), "+c"(n)
             :
-            : "D"(dest), "S"(src), "c"(n)
             : "edx", "memory", "cc"
     );
     return dest;
 }
 
+/* void* memcpy_sse2(void* dest, const void* src, uint32_t n);
+ * Inputs:      void* dest = destination of copy
+ *         const void* src = source of copy
+ *              uint32_t n = number of bytes to copy, at least SSE_MIN_BYTES
+ * Return Value: pointer to dest
+ * Function: memcpy with 16 byte loads and aligned stores. Every block is loaded before
+ *           any of it is stored, so like memcpy it copies forward safely */
+void* memcpy_sse2(void* dest, const void* src, uint32_t n) {
+    uint8_t* d = (uint8_t*)dest;
+    const uint8_t* s = (const uint8_t*)src;
+    uint32_t head = (0 - (uint32_t)d) & (SSE_ALIGN - 1);
+    uint32_t blocks;
+    kernel_fpu_t save;
+
+    memcpy(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    blocks = n / SSE_BLOCK;
+    kernel_fpu_begin(&save);
+    asm volatile ("                             \n\
+            1:                                  \n\
+            movdqu  (%%esi), %%xmm0             \n\
+            movdqu  16(%%esi), %%xmm1           \n\
+            movdqu  32(%%esi), %%xmm2           \n\
+            movdqu  48(%%esi), %%xmm3           \n\
+            movdqa  %%xmm0, (%%edi)             \n\
+            movdqa  %%xmm1, 16(%%edi)           \n\
+            movdqa  %%xmm2, 32(%%edi)           \n\
+            movdqa  %%xmm3, 48(%%edi)           \n\
+            addl    $64, %%esi                  \n\
+            addl    $64, %%edi                  \n\
+            decl    %%ecx                       \n\
+            jnz     1b                          \n\
+            "
+            : "+S"(s), "+D"(d), "+c"(blocks)
+            :
+            : "memory", "cc"
+    );
+    kernel_fpu_end(&save);
+    memcpy(d, s, n % SSE_BLOCK);
+    return dest;
+}
+
+/* void* memset_sse2(void* s, int32_t c, uint32_t n);
+ * Inputs:    void* s = pointer to memory
+ *          int32_t c = value to set memory to, 0 to 255
+ *         uint32_t n = number of bytes to set, at least SSE_MIN_BYTES
+ * Return Value: s
+ * Function: memset with aligned 16 byte stores */
+void* memset_sse2(void* s, int32_t c, uint32_t n) {
+    uint8_t* d = (uint8_t*)s;
+    uint32_t head = (0 - (uint32_t)d) & (SSE_ALIGN - 1);
+    uint32_t blocks;
+    uint32_t pattern = c * ONES;
+    kernel_fpu_t save;
+
+    memset(d, c, head);
+    d += head;
+    n -= head;
+    blocks = n / SSE_BLOCK;
+    kernel_fpu_begin(&save);
+    asm volatile ("                             \n\
+            movd    %2, %%xmm0                  \n\
+            pshufd  $0, %%xmm0, %%xmm0          \n\
+            1:                                  \n\
+            movdqa  %%xmm0, (%%edi)             \n\
+            movdqa  %%xmm0, 16(%%edi)           \n\
+            movdqa  %%xmm0, 32(%%edi)           \n\
+            movdqa  %%xmm0, 48(%%edi)           \n\
+            addl    $64, %%edi                  \n\
+            decl    %%ecx                       \n\
+            jnz     1b                          \n\
+            "
+            : "+D"(d), "+c"(blocks)
+            : "r"(pattern)
+            : "memory", "cc"
+    );
+    kernel_fpu_end(&save);
+    memset(d, c, n % SSE_BLOCK);
+    return s;
+}
+
 /* int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n)
  * Inputs: const int8_t* s1 = first string to compare
  *         const int8_t* s2 = second string to compare
@@ -511,8 +807,23 @@ void* memmove(void* dest, const void* src, uint32_t n) {
  *               indicates the opposite.
  * Function: compares string 1 and string 2 for equality */
 int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n) {
-    int32_t i;
-    for (i = 0; i < n; i++) {
+    uint32_t i = 0;
+    uint32_t w1;
+
+    // a word at a time while both strings are aligned the same way, up to the word that
+    // differs or holds the end of s1, which the byte loop below finishes
+    if ((((uint32_t)s1 ^ (uint32_t)s2) & WORD_MASK) == 0) {
+        for (; i < n && ((uint32_t)(s1 + i) & WORD_MASK) != 0; i++) {
+            if ((s1[i] != s2[i]) || (s1[i] == '\0'))
+                return s1[i] - s2[i];
+        }
+        for (; n - i >= sizeof(uint32_t); i += sizeof(uint32_t)) {
+            w1 = *(const uint32_t*)(s1 + i);
+            if (w1 != *(const uint32_t*)(s2 + i) || HAS_ZERO_BYTE(w1))
+                break;
+        }
+    }
+    for (; i < n; i++) {
         if ((s1[i] != s2[i]) || (s1[i] == '\0') /* || s2[i] == '\0' */) {
 
             /* The s2[i] == '\0' is unnecessary because of the short-circuit
@@ -546,17 +857,13 @@ int8_t* strcpy(int8_t* dest, const int8_t* src) {
  *         const int8_t* src = source string of copy
  *                uint32_t n = number of bytes to copy
  * Return Value: pointer to dest
- * Function: copy n bytes of the source string into the destination string */
+ * Function: copy n bytes of the source string into the destination string, padding with
+ *           NULs after its end */
 int8_t* strncpy(int8_t* dest, const int8_t* src, uint32_t n) {
-    int32_t i = 0;
-    while (src[i] != '\0' && i < n) {
-        dest[i] = src[i];
-        i++;
-    }
-    while (i < n) {
-        dest[i] = '\0';
-        i++;
-    }
+    uint32_t len = strnlen(src, n);
+
+    memcpy(dest, src, len);
+    memset(dest + len, 0, n - len);
     return dest;
 }
 
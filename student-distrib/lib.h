@@ -6,13 +6,26 @@
 #define _LIB_H
 
 #include "types.h"
+
+/* variable arguments, from the compiler since the kernel builds without its headers */
+typedef __builtin_va_list va_list;
+#define va_start(ap, last)  __builtin_va_start(ap, last)
+#define va_arg(ap, type)    __builtin_va_arg(ap, type)
+#define va_end(ap)          __builtin_va_end(ap)
+
 void test_interrupts(void);
 int32_t printf(int8_t *format, ...);
+int32_t snprintf(int8_t* buf, uint32_t size, const int8_t* format, ...);
+int32_t vsnprintf(int8_t* buf, uint32_t size, const int8_t* format, va_list ap);
 void putc(uint8_t c);
+void vga_putc(uint8_t c);
+void vga_write(const int8_t* buf, uint32_t n);
+int32_t console_write(const int8_t* buf, uint32_t n);
 int32_t puts(int8_t *s);
 int8_t *itoa(uint32_t value, int8_t* buf, int32_t radix);
 int8_t *strrev(int8_t* s);
 uint32_t strlen(const int8_t* s);
+uint32_t strnlen(const int8_t* s, uint32_t n);
 void clear(void);
 void vertical_scroll();
 void background_scroll(int term_idx, char* vidmem);
@@ -26,6 +39,8 @@ void* memset_word(void* s, int32_t c, uint32_t n);
 void* memset_dword(void* s, int32_t c, uint32_t n);
 void* memcpy(void* dest, const void* src, uint32_t n);
 void* memmove(void* dest, const void* src, uint32_t n);
+void* memcpy_sse2(void* dest, const void* src, uint32_t n);
+void* memset_sse2(void* s, int32_t c, uint32_t n);
 int32_t strncmp(const int8_t* s1, const int8_t* s2, uint32_t n);
 int8_t* strcpy(int8_t* dest, const int8_t*src);
 int8_t* strncpy(int8_t* dest, const int8_t*src, uint32_t n);
@@ -34,6 +49,8 @@ int8_t* strncpy(int8_t* dest, const int8_t*src, uint32_t n);
 int32_t bad_userspace_addr(const void* addr, int32_t len);
 int32_t safe_strncpy(int8_t* dest, const int8_t* src, int32_t n);
 
+#define RAW_EVENT_LIM 64   // raw key event ring size, power of 2
+
 typedef struct terminal_storage {
     uint32_t curr_pid;
     int save_x;
@@ -44,6 +61,9 @@ typedef struct terminal_storage {
     int32_t* video_page;
     uint8_t active;
     uint8_t* terminal_buf;
+    uint8_t raw_events[RAW_EVENT_LIM];      // scan codes queued while the reader is in raw mode
+    volatile uint32_t raw_head;             // next event to hand to terminal_read
+    volatile uint32_t raw_tail;             // next free slot for the keyboard handler
 }terminal_storage;
 
 terminal_storage terminal[3];
@@ -52,6 +72,19 @@ uint8_t enter_read_flag_one;
 uint8_t enter_read_flag_two;
 
 
+/* Compiler barrier - keeps memory accesses from being reordered across it */
+#define barrier()                       \
+do {                                    \
+    asm volatile ("" : : : "memory");   \
+} while (0)
+
+/* Reads the time-stamp counter */
+static inline uint64_t rdtsc(void) {
+    uint64_t val;
+    asm volatile ("rdtsc" : "=A"(val));
+    return val;
+}
+
 /* Port read functions */
 /* Inb reads a byte and returns its value as a zero-extended 32-bit
  * unsigned int */
@@ -85,4 +85,27 @@ void init_paging() {
     enable_paging(page_dir);
 }
 
+/* uint32_t user_phys_addr(uint32_t addr)
+ * inputs: addr -- virtual address in the current address space
+ * outputs: physical address, 0 if addr is not mapped for user programs
+ * Function: walks the page directory and, for 4KB pages, the page table
+ */
+uint32_t user_phys_addr(uint32_t addr){
+    pd_entry_page pde;
+    pt_entry_page pte;
+    uint32_t* table;
 
+    pde.val = page_dir[addr >> 22];                 // top 10 bits index the directory
+    if(!pde.present || !pde.u_s){
+        return 0;
+    }
+    if(pde.page_size){                              // 4MB page
+        return (pde.page_base_31_22 << 22) | (addr & (FOUR_MB_MASK));
+    }
+    table = (uint32_t*)(pde.val & ~(FOUR_KB - 1));  // page tables live in the kernel's own page
+    pte.val = table[(addr >> 12) & (KB - 1)];       // next 10 bits index the table
+    if(!pte.present || !pte.u_s){
+        return 0;
+    }
+    return (pte.page_base_31_12 << 12) | (addr & (FOUR_KB - 1));
+}
@@ -6,6 +6,7 @@
 #define KB      1024
 #define VIDEO   0xB8000
 #define FOUR_KB 4096
+#define FOUR_MB_MASK 0x3FFFFF
 #define FIRST_TERMINAL_BUF (0xB8000 + 4096) 
 #define SECOND_TERMINAL_BUF (0xB8000 + 4096 * 2) 
 #define THIRD_TERMINAL_BUF (0xB8000 + 4096 * 3)
@@ -84,6 +85,9 @@ uint32_t vidmap_page_table[KB] __attribute__((aligned (FOUR_KB)));
 /* Initialize paging */
 void init_paging();
 
+/* Physical address behind a user virtual address, 0 if unmapped */
+uint32_t user_phys_addr(uint32_t addr);
+
 extern uint32_t* page_dir_pointer;
 
 extern void enable_paging(uint32_t* page_dir_pointer);
@@ -0,0 +1,282 @@
+/* pipe.c: pipes between processes, backed by kernel ring buffers
+ * A pipe is a PIPE_BUF_SIZE ring with a read end and a write end, each an fd whose inode field
+ * is the pipe index. A reader sleeps while the ring is empty and a writer while it is full,
+ * each side wakes the other, so the two processes of a pipeline take turns instead of
+ * spinning. Ends are counted across processes: reads return 0 once every write end is closed
+ * and writes fail once every read end is closed.
+ */
+
+#include "pipe.h"
+#include "lib.h"
+#include "system_call.h"
+#include "poll.h"
+#include "thread.h"
+
+static pipe_t pipes[PIPE_MAX];
+
+fop_table_t pipe_read_fop = {
+    pipe_open,
+    pipe_close,
+    pipe_read,
+    pipe_invalid_write,
+    pipe_poll
+};
+fop_table_t pipe_write_fop = {
+    pipe_open,
+    pipe_close,
+    pipe_invalid_read,
+    pipe_write,
+    pipe_poll
+};
+
+/* int32_t pipe(int32_t* fds);
+ * Inputs: int32_t* fds -- user array for the read end (fds[0]) and the write end (fds[1])
+ * Return Value: 0 on success, -1 for a bad pointer or when no pipe or descriptor is free
+ *  Function: system call, creates a pipe in the caller's descriptor table */
+int32_t pipe(int32_t* fds){
+    int32_t read_fd, write_fd;
+
+    if(!user_buffer_ok(fds, 2 * sizeof(int32_t))){
+        return FAIL_NEG_ONE;
+    }
+    if(pipe_create(&read_fd, &write_fd) == FAIL_NEG_ONE){
+        return FAIL_NEG_ONE;
+    }
+    fds[0] = read_fd;
+    fds[1] = write_fd;
+    return 0;
+}
+
+/* int32_t pipe_create(int32_t* read_fd, int32_t* write_fd);
+ * Inputs: int32_t* read_fd, int32_t* write_fd -- kernel pointers for the two descriptors
+ * Return Value: 0 on success, -1 when no pipe or descriptor is free
+ *  Function: takes a free pipe and two descriptors of the current process */
+int32_t pipe_create(int32_t* read_fd, int32_t* write_fd){
+    uint32_t flags;
+    uint32_t idx;
+    pipe_t* p;
+
+    cli_and_save(flags);
+    for(idx = 0; idx < PIPE_MAX; idx++){
+        if(!pipes[idx].in_use){
+            break;
+        }
+    }
+    if(idx == PIPE_MAX){
+        restore_flags(flags);
+        return FAIL_NEG_ONE;
+    }
+    *read_fd = alloc_fd(&pipe_read_fop, idx, 0);
+    if(*read_fd == FAIL_NEG_ONE){
+        restore_flags(flags);
+        return FAIL_NEG_ONE;
+    }
+    *write_fd = alloc_fd(&pipe_write_fop, idx, 0);
+    if(*write_fd == FAIL_NEG_ONE){
+        files_pcb()->file_descriptor[*read_fd].flags = 0;
+        restore_flags(flags);
+        return FAIL_NEG_ONE;
+    }
+    p = &pipes[idx];
+    p->in_use = 1;
+    p->readers = 1;
+    p->writers = 1;
+    p->head = 0;
+    p->tail = 0;
+    p->read_wait.head = NULL;
+    p->write_wait.head = NULL;
+    restore_flags(flags);
+    return 0;
+}
+
+/* void pipe_dup(file_descriptor* fd);
+ * Inputs: file_descriptor* fd -- a descriptor that was just copied
+ * Return Value: none
+ *  Function: counts the copy if it is a pipe end, does nothing for other files */
+void pipe_dup(file_descriptor* fd){
+    uint32_t flags;
+    cli_and_save(flags);
+    if(fd->file_operations_table_pointer == &pipe_read_fop){
+        pipes[fd->inode].readers++;
+    }else if(fd->file_operations_table_pointer == &pipe_write_fop){
+        pipes[fd->inode].writers++;
+    }
+    restore_flags(flags);
+}
+
+/* void pipe_usage(uint32_t* count, uint32_t* queued);
+ * Inputs: uint32_t* count -- set to the pipes in use
+ *         uint32_t* queued -- set to the bytes written to them and not read yet
+ * Return Value: none
+ *  Function: memory statistics for procfs.c */
+void pipe_usage(uint32_t* count, uint32_t* queued){
+    int32_t idx;
+
+    *count = 0;
+    *queued = 0;
+    for(idx = 0; idx < PIPE_MAX; idx++){
+        if(pipes[idx].in_use){
+            (*count)++;
+            *queued += pipes[idx].tail - pipes[idx].head;
+        }
+    }
+}
+
+/* int32_t pipe_open(const uint8_t* filename);
+ * Inputs: not used
+ * Return Value: -1, pipes have no name and are made by pipe
+ *  Function: none */
+int32_t pipe_open(const uint8_t* filename){
+    return FAIL_NEG_ONE;
+}
+
+/* int32_t pipe_close(int32_t fd);
+ * Inputs: int32_t fd -- read or write end of the current process
+ * Return Value: 0
+ *  Function: drops one end, waking the other side so it sees end of file or a broken pipe.
+ *            The pipe is free again once both sides are gone */
+int32_t pipe_close(int32_t fd){
+    uint32_t flags;
+    file_descriptor* desc = &files_pcb()->file_descriptor[fd];
+    pipe_t* p = &pipes[desc->inode];
+
+    cli_and_save(flags);
+    if(desc->file_operations_table_pointer == &pipe_read_fop){
+        p->readers--;
+        wake_up(&p->write_wait);
+    }else{
+        p->writers--;
+        wake_up(&p->read_wait);
+    }
+    poll_notify();
+    if(p->readers == 0 && p->writers == 0){
+        p->in_use = 0;
+    }
+    desc->flags = 0;
+    restore_flags(flags);
+    return 0;
+}
+
+/* int32_t pipe_read(int32_t fd, void* buf, int32_t n);
+ * Inputs: int32_t fd -- read end
+ *         void* buf -- user buffer
+ *         int32_t n -- most bytes to read
+ * Return Value: bytes read, 0 at end of file, -1 if a signal arrived while it was empty
+ *  Function: sleeps until the pipe has data or has no writers left, then copies what is there */
+int32_t pipe_read(int32_t fd, void* buf, int32_t n){
+    uint32_t flags;
+    pipe_t* p = &pipes[files_pcb()->file_descriptor[fd].inode];
+    uint32_t count, first;
+
+    if(n <= 0){
+        return 0;
+    }
+    cli_and_save(flags);
+    while(p->head == p->tail){
+        if(p->writers == 0){
+            restore_flags(flags);
+            return 0;
+        }
+        if(wait_event(&p->read_wait, TIMER_NO_DEADLINE) == -1){
+            restore_flags(flags);
+            return FAIL_NEG_ONE;
+        }
+    }
+    count = p->tail - p->head;
+    if(count > (uint32_t)n){
+        count = n;
+    }
+    first = PIPE_BUF_SIZE - (p->head & PIPE_MASK);     // bytes before the ring wraps
+    if(first > count){
+        first = count;
+    }
+    memcpy(buf, &p->buf[p->head & PIPE_MASK], first);
+    memcpy((uint8_t*)buf + first, p->buf, count - first);
+    p->head += count;
+    wake_up(&p->write_wait);
+    poll_notify();
+    restore_flags(flags);
+    return count;
+}
+
+/* int32_t pipe_write(int32_t fd, const void* buf, int32_t n);
+ * Inputs: int32_t fd -- write end
+ *         const void* buf -- user data
+ *         int32_t n -- bytes to write
+ * Return Value: n, or -1 if every read end is closed. A signal while the pipe is full ends
+ *               the write early with the bytes already in, -1 if there are none
+ *  Function: copies as much as fits, sleeping while the pipe is full, until all n bytes are in */
+int32_t pipe_write(int32_t fd, const void* buf, int32_t n){
+    uint32_t flags;
+    pipe_t* p = &pipes[files_pcb()->file_descriptor[fd].inode];
+    uint32_t written = 0;
+    uint32_t count, first;
+
+    cli_and_save(flags);
+    while(written < (uint32_t)n){
+        if(p->readers == 0){
+            restore_flags(flags);
+            return FAIL_NEG_ONE;
+        }
+        count = PIPE_BUF_SIZE - (p->tail - p->head);
+        if(count == 0){
+            if(wait_event(&p->write_wait, TIMER_NO_DEADLINE) == -1){
+                restore_flags(flags);
+                return written ? (int32_t)written : FAIL_NEG_ONE;
+            }
+            continue;
+        }
+        if(count > n - written){
+            count = n - written;
+        }
+        first = PIPE_BUF_SIZE - (p->tail & PIPE_MASK);
+        if(first > count){
+            first = count;
+        }
+        memcpy(&p->buf[p->tail & PIPE_MASK], (const uint8_t*)buf + written, first);
+        memcpy(p->buf, (const uint8_t*)buf + written + first, count - first);
+        p->tail += count;
+        written += count;
+        wake_up(&p->read_wait);
+        poll_notify();
+    }
+    restore_flags(flags);
+    return written;
+}
+
+/* int32_t pipe_poll(int32_t fd);
+ * Inputs: int32_t fd -- read or write end
+ * Return Value: POLLIN when a read would not block, POLLHUP without writers, POLLOUT when
+ *               there is room, POLLERR without readers
+ *  Function: readiness of one end for poll */
+int32_t pipe_poll(int32_t fd){
+    file_descriptor* desc = &files_pcb()->file_descriptor[fd];
+    pipe_t* p = &pipes[desc->inode];
+
+    if(desc->file_operations_table_pointer == &pipe_read_fop){
+        if(p->writers == 0){
+            return POLLIN | POLLHUP;        // read returns end of file at once
+        }
+        return p->head != p->tail ? POLLIN : 0;
+    }
+    if(p->readers == 0){
+        return POLLERR;
+    }
+    return p->tail - p->head < PIPE_BUF_SIZE ? POLLOUT : 0;
+}
+
+/* int32_t pipe_invalid_read(int32_t fd, void* buf, int32_t n);
+ * Inputs: not used
+ * Return Value: -1, the write end cannot be read
+ *  Function: none */
+int32_t pipe_invalid_read(int32_t fd, void* buf, int32_t n){
+    return FAIL_NEG_ONE;
+}
+
+/* int32_t pipe_invalid_write(int32_t fd, const void* buf, int32_t n);
+ * Inputs: not used
+ * Return Value: -1, the read end cannot be written
+ *  Function: none */
+int32_t pipe_invalid_write(int32_t fd, const void* buf, int32_t n){
+    return FAIL_NEG_ONE;
+}
@@ -0,0 +1,41 @@
+/* pipe.h: pipes between processes, backed by kernel ring buffers */
+
+#ifndef _PIPE_H
+#define _PIPE_H
+
+#include "types.h"
+#include "filesys.h"
+#include "timer.h"
+
+#define PIPE_MAX        8
+#define PIPE_BUF_SIZE   4096                    // power of two
+#define PIPE_MASK       (PIPE_BUF_SIZE - 1)
+
+typedef struct pipe_t {
+    uint32_t in_use;
+    uint32_t readers;                           // open read ends, across processes
+    uint32_t writers;                           // open write ends
+    uint32_t head;                              // next byte to read, only grows
+    uint32_t tail;                              // next byte to write, only grows
+    wait_queue_t read_wait;                     // readers waiting for data
+    wait_queue_t write_wait;                    // writers waiting for room
+    uint8_t buf[PIPE_BUF_SIZE];
+} pipe_t;
+
+extern fop_table_t pipe_read_fop;
+extern fop_table_t pipe_write_fop;
+
+int32_t pipe(int32_t* fds);
+int32_t pipe_create(int32_t* read_fd, int32_t* write_fd);
+void pipe_dup(file_descriptor* fd);
+void pipe_usage(uint32_t* count, uint32_t* queued);
+
+int32_t pipe_open(const uint8_t* filename);
+int32_t pipe_close(int32_t fd);
+int32_t pipe_read(int32_t fd, void* buf, int32_t n);
+int32_t pipe_write(int32_t fd, const void* buf, int32_t n);
+int32_t pipe_poll(int32_t fd);
+int32_t pipe_invalid_read(int32_t fd, void* buf, int32_t n);
+int32_t pipe_invalid_write(int32_t fd, const void* buf, int32_t n);
+
+#endif /* _PIPE_H */
@@ -1,16 +1,25 @@
 #include "pit.h"
 #include "scheduling.h"
+#include "softirq.h"
+#include "vdso.h"
 
-/* void rtc_init()
- * Initialize the RTC
+volatile uint32_t pit_ticks = 0;    // PIT interrupts since boot
+static volatile uint32_t switch_deferred = 0;  // a tick during do_softirq still has to switch tasks
+
+/* void pit_init()
+ * Initialize the PIT
  * inputs: none
  * outputs: none
- * side effects: sets up the PIT and enables IRQ0
+ * side effects: sets channel 0 to PIT_HZ and enables IRQ0
  */
 void pit_init() {
     /* Disable interrupts */
     cli();
 
+    outb(PIT_CH0_RATE, PIT_CMD);
+    outb(PIT_DIVISOR & 0xFF, PIT_CH0_DATA);
+    outb((PIT_DIVISOR >> 8) & 0xFF, PIT_CH0_DATA);
+
     // /* Enable RTC interrupts */
     enable_irq(PIT_PIC_PIN);
 
@@ -22,11 +31,35 @@ void pit_init() {
  * Interrupt handler for PIT
  * inputs: none
  * outputs: none
- * side effects: switches to the next active process using the scheduler function
+ * side effects: refreshes the time page, raises the timer softirq and switches to the next active process using the
+ *               scheduler function. The switch stays in the top half since it changes stacks. A tick that interrupts
+ *               do_softirq only notes the switch, pit_deferred_switch makes it once the softirqs are done.
  */
 void pit_handler(){
     cli();
-    scheduler(); // call scheduler
+    pit_ticks++;
+    vdso_update();
+    raise_softirq(SOFTIRQ_TIMER);
+    if(softirq_running()){
+        switch_deferred = 1;
+        send_eoi(PIT_PIC_PIN);
+    }else{
+        scheduler(); // call scheduler
+    }
     sti();
 }
 
+/* void pit_deferred_switch()
+ * inputs: none
+ * outputs: none
+ * side effects: makes the task switch of a tick that came while do_softirq ran, called by hardware_handler after
+ *               do_softirq. Does nothing while an interrupted do_softirq still has to finish.
+ */
+void pit_deferred_switch(){
+    cli();
+    if(switch_deferred && !softirq_running()){
+        switch_deferred = 0;
+        scheduler();
+    }
+}
+
@@ -4,6 +4,14 @@
 #include "i8259.h"
 
 #define PIT_PIC_PIN     0
+#define PIT_CH0_DATA    0x40
+#define PIT_CMD         0x43
+#define PIT_CH0_RATE    0x34        // channel 0, lobyte/hibyte, mode 2 rate generator
+#define PIT_HZ          100         // scheduler and timer tick
+#define PIT_DIVISOR     ((1193182 + PIT_HZ/2) / PIT_HZ)
+
+extern volatile uint32_t pit_ticks;    // PIT interrupts since boot
 
 void pit_init(void);
 void pit_handler(void);
+void pit_deferred_switch(void);
@@ -0,0 +1,88 @@
+/* poll.c: waiting for any of several file descriptors
+ * Every file type reports its readiness through the poll member of its fop table. A process
+ * in poll that finds nothing ready sleeps on the single poll_wait queue. Drivers call
+ * poll_notify whenever input arrives or room frees up, which wakes every poller to scan
+ * its descriptors again; with a handful of processes that is cheaper than per-file queues.
+ */
+
+#include "poll.h"
+#include "lib.h"
+#include "clock.h"
+#include "system_call.h"
+#include "thread.h"
+
+wait_queue_t poll_wait;
+
+/* void poll_notify(void)
+ * inputs: none
+ * outputs: none
+ * Function: wakes the processes sleeping in poll, safe from interrupt context
+ */
+void poll_notify(void){
+    if(poll_wait.head != NULL){
+        wake_up(&poll_wait);
+    }
+}
+
+/* int32_t poll_scan(pollfd_t* fds, uint32_t nfds)
+ * inputs: fds -- entries to fill in, read and written directly
+ *         nfds -- number of entries
+ * outputs: number of entries with revents set
+ * Function: asks the file of every entry for its readiness. A file type without a poll
+ *           function never blocks, so it is always ready.
+ */
+int32_t poll_scan(pollfd_t* fds, uint32_t nfds){
+    file_descriptor* desc = files_pcb()->file_descriptor;
+    fop_table_t* fop;
+    uint32_t i;
+    int32_t mask, ready = 0;
+
+    for(i = 0; i < nfds; i++){
+        if(fds[i].fd < 0 || fds[i].fd > FD_MAX || desc[fds[i].fd].flags != 1){
+            mask = POLLNVAL;
+        }else{
+            fop = desc[fds[i].fd].file_operations_table_pointer;
+            mask = fop->poll != NULL ? fop->poll(fds[i].fd) : (POLLIN | POLLOUT);
+        }
+        fds[i].revents = mask & (fds[i].events | POLLERR | POLLHUP | POLLNVAL);
+        if(fds[i].revents){
+            ready++;
+        }
+    }
+    return ready;
+}
+
+/* int32_t poll(pollfd_t* fds, uint32_t nfds, int32_t timeout_ms);
+ * Inputs: pollfd_t* fds -- entries in the user page
+ *         uint32_t nfds -- number of entries, at most POLL_MAX_FDS
+ *         int32_t timeout_ms -- longest wait, 0 to only check, negative to wait forever
+ * Return Value: number of ready entries, 0 on timeout, -1 on a bad array or if a signal
+ *               arrived before any entry was ready
+ *  Function: system call, sleeps until one of the files is ready or the timeout passes and
+ *            fills in revents of every entry */
+int32_t poll(pollfd_t* fds, uint32_t nfds, int32_t timeout_ms){
+    uint64_t deadline = TIMER_NO_DEADLINE;
+    int32_t ready;
+
+    if(nfds == 0 || nfds > POLL_MAX_FDS || !user_buffer_ok(fds, nfds * sizeof(pollfd_t))){
+        return FAIL_NEG_ONE;
+    }
+    if(timeout_ms > 0){
+        deadline = clock_ns() + (uint64_t)timeout_ms * NS_PER_MS;
+        if(deadline == TIMER_NO_DEADLINE){
+            deadline = 1;
+        }
+    }
+    cli();                                  // no poll_notify between the scan and the sleep
+    while((ready = poll_scan(fds, nfds)) == 0 && timeout_ms != 0){
+        if(wait_event(&poll_wait, deadline) == -1){
+            ready = poll_scan(fds, nfds);   // timed out, report the last state
+            if(ready == 0 && clock_ns() < deadline){
+                ready = FAIL_NEG_ONE;       // a signal ended the wait before the timeout
+            }
+            break;
+        }
+    }
+    sti();
+    return ready;
+}
@@ -0,0 +1,32 @@
+/* poll.h: waiting for any of several file descriptors */
+
+#ifndef _POLL_H
+#define _POLL_H
+
+#include "types.h"
+#include "timer.h"
+
+/* readiness bits, the same values as POSIX */
+#define POLLIN      0x01                    // read will not block
+#define POLLOUT     0x04                    // write will not block
+#define POLLERR     0x08                    // write end of a pipe without readers
+#define POLLHUP     0x10                    // read end of a pipe without writers
+#define POLLNVAL    0x20                    // fd is not open
+
+#define POLL_MAX_FDS    8                   // one entry per descriptor of a process
+
+typedef struct pollfd_t {
+    int32_t fd;
+    int16_t events;                         // bits the caller waits for
+    int16_t revents;                        // bits that are set, POLLERR/HUP/NVAL always reported
+} pollfd_t;
+
+extern wait_queue_t poll_wait;
+
+void poll_notify(void);
+int32_t poll_scan(pollfd_t* fds, uint32_t nfds);
+
+/* system call */
+int32_t poll(pollfd_t* fds, uint32_t nfds, int32_t timeout_ms);
+
+#endif /* _POLL_H */
@@ -0,0 +1,322 @@
+/* procfs.c - synthetic files whose text is generated on every read
+ * The files have dentries of type PROC_FILE_TYPE that are not in the file system image:
+ * open finds them when read_dentry_by_name does not and directory reads list them after the
+ * image's entries, so ls shows them and cat reads them. Nothing is kept between reads, every
+ * read runs the file's show function again and copies out the part at the file position, so
+ * "cat ps" in one terminal shows what the others are doing right now. A read sees one
+ * moment, a file longer than the reader's buffer can mix lines from different ones.
+ *     ps          one line per task: pid, parent, state, terminal, slot, ticks, switches
+ *     sched       scheduler counters and who runs from each slot
+ *     interrupts  IRQ, exception and softirq counts
+ *     meminfo     memory used by tasks, programs, shared memory and pipes
+ *     terminals   foreground task, input mode and pending input of each terminal
+ */
+
+#include "procfs.h"
+#include "lib.h"
+#include "clock.h"
+#include "system_call.h"
+#include "scheduling.h"
+#include "idt_handler.h"
+#include "softirq.h"
+#include "sysstat.h"
+#include "shm.h"
+#include "pipe.h"
+#include "pit.h"
+#include "keyboard.h"
+#include "terminal.h"
+#include "thread.h"
+
+#define NS_PER_MS       1000000
+#define NUM_TERMINALS   3
+
+extern uint8_t _end[];      // end of the kernel image, from the linker
+
+typedef struct procfs_file_t {
+    const int8_t* name;
+    void (*show)(vfile_t* vf);
+} procfs_file_t;
+
+static void procfs_ps(vfile_t* vf);
+static void procfs_sched(vfile_t* vf);
+static void procfs_interrupts(vfile_t* vf);
+static void procfs_meminfo(vfile_t* vf);
+static void procfs_terminals(vfile_t* vf);
+
+static const procfs_file_t procfs_files[] = {
+    {"ps", procfs_ps},
+    {"sched", procfs_sched},
+    {"interrupts", procfs_interrupts},
+    {"meminfo", procfs_meminfo},
+    {"terminals", procfs_terminals}
+};
+
+#define PROCFS_FILES    (sizeof(procfs_files) / sizeof(procfs_files[0]))
+
+static const int8_t* irq_names[NUM_IRQS] = {
+    "pit", "keyboard", "cascade", NULL, "serial", NULL, NULL, NULL,
+    "rtc", NULL, NULL, NULL, NULL, NULL, NULL, NULL
+};
+
+/* same names exc_handler prints */
+static const int8_t* exc_names[NUM_EXCEPTIONS] = {
+    "div_by_zero", "single_step", "nmi", "breakpoint", "overflow", "bound_range",
+    "inv_opcode", "coprocessor_na", "double_fault", "coprocessor_seg_ovr", "inv_task",
+    "seg_not_present", "stack_segfault", "general_protection", "page", "reserved",
+    "x87_float", "alignment", "machine", "simd"
+};
+
+static const int8_t* softirq_names[NUM_SOFTIRQS] = {"timer", "keyboard", "rtc", "serial"};
+
+/* terminal_mode bits TERM_RAW and TERM_NONBLOCK */
+static const int8_t* mode_names[TERM_MODE_MASK + 1] = {"line", "raw", "line+nb", "raw+nb"};
+
+fop_table_t procfs_fop = {
+    procfs_open,
+    procfs_close,
+    procfs_read,
+    procfs_write
+};
+
+/* uint32_t procfs_count(void)
+ * Inputs: none
+ * Return Value: number of synthetic files
+ * Function: tells directory_read where the listing ends */
+uint32_t procfs_count(void){
+    return PROCFS_FILES;
+}
+
+/* uint32_t procfs_dentry_by_index(uint32_t index, dentry_t* dentry)
+ * Inputs: uint32_t index -- file, 0 to procfs_count() - 1
+ *         dentry_t* dentry -- filled in if index is valid
+ * Return Value: 0 if found, -1 else
+ * Function: makes the dentry of a synthetic file, the inode is the index */
+uint32_t procfs_dentry_by_index(uint32_t index, dentry_t* dentry){
+    if(index >= PROCFS_FILES){
+        return -1;
+    }
+    memset(dentry, 0, sizeof(dentry_t));
+    strncpy((int8_t*)dentry->filename, procfs_files[index].name, DENTRY_FILE_NAME_LEN);
+    dentry->file_type = PROC_FILE_TYPE;
+    dentry->inode_num = index;
+    return 0;
+}
+
+/* uint32_t procfs_dentry_by_name(const uint8_t* fname, dentry_t* dentry)
+ * Inputs: const uint8_t* fname -- name of the file
+ *         dentry_t* dentry -- filled in if found
+ * Return Value: 0 if found, -1 else
+ * Function: looks up a synthetic file, like read_dentry_by_name does in the image */
+uint32_t procfs_dentry_by_name(const uint8_t* fname, dentry_t* dentry){
+    uint32_t idx;
+
+    if(strlen((const int8_t*)fname) > DENTRY_FILE_NAME_LEN){
+        return -1;
+    }
+    for(idx = 0; idx < PROCFS_FILES; idx++){
+        if(!strncmp((const int8_t*)fname, procfs_files[idx].name, DENTRY_FILE_NAME_LEN)){
+            return procfs_dentry_by_index(idx, dentry);
+        }
+    }
+    return -1;
+}
+
+/* int32_t procfs_open(const uint8_t* filename)
+ * Inputs: const uint8_t* filename -- name of a synthetic file
+ * Return Value: file descriptor, -1 if there is no such file or no descriptor is free
+ * Function: opens the file at position 0 */
+int32_t procfs_open(const uint8_t* filename){
+    dentry_t dentry;
+
+    if(procfs_dentry_by_name(filename, &dentry) == -1){
+        return FAIL_NEG_ONE;
+    }
+    return alloc_fd(&procfs_fop, dentry.inode_num, 0);
+}
+
+/* int32_t procfs_close(int32_t fd)
+ * Inputs: int32_t fd -- file descriptor
+ * Return Value: 0
+ * Function: releases the descriptor */
+int32_t procfs_close(int32_t fd){
+    files_pcb()->file_descriptor[fd].flags = 0;
+    return 0;
+}
+
+/* int32_t procfs_read(int32_t fd, void* buf, int32_t nbytes)
+ * Inputs: int32_t fd -- file descriptor
+ *         void* buf -- user buffer
+ *         int32_t nbytes -- its size
+ * Return Value: bytes read, 0 at the end
+ * Function: generates the text of the file with interrupts off, so the tasks and counters
+ *           it walks hold still, and copies out the part at the file position */
+int32_t procfs_read(int32_t fd, void* buf, int32_t nbytes){
+    vfile_t vf;
+    uint32_t flags;
+
+    cli_and_save(flags);
+    vfile_begin(&vf, fd, buf, nbytes);
+    procfs_files[files_pcb()->file_descriptor[fd].inode].show(&vf);
+    restore_flags(flags);
+    return vfile_end(&vf, fd);
+}
+
+/* int32_t procfs_write(int32_t fd, const void* buf, int32_t nbytes)
+ * Inputs: not used
+ * Return Value: -1, the files are read-only
+ * Function: none */
+int32_t procfs_write(int32_t fd, const void* buf, int32_t nbytes){
+    return FAIL_NEG_ONE;
+}
+
+/* int8_t task_state(pcb_struct* pcb)
+ * Inputs: pcb_struct* pcb -- live task
+ * Return Value: Z for a zombie, S while blocked, R otherwise
+ * Function: one letter state for ps and sched */
+static int8_t task_state(pcb_struct* pcb){
+    if(pcb->zombie) return 'Z';
+    return (pcb->state == PROC_BLOCKED) ? 'S' : 'R';
+}
+
+/* void procfs_ps(vfile_t* vf)
+ * Inputs: vfile_t* vf -- read in progress
+ * Return Value: none
+ * Function: text of "ps", one line per live PCB slot */
+static void procfs_ps(vfile_t* vf){
+    pcb_struct* pcb;
+    const int8_t* type;
+    int32_t pid;
+
+    vfile_printf(vf, "  PID  PPID S TTY SLOT    TICKS SWITCHES TYPE    NAME\n");
+    for(pid = 0; pid < MAX_TASKS; pid++){
+        pcb = task_pcb(pid);
+        if(pcb == NULL) continue;
+        if(pcb->kthread){
+            type = "kthread";
+        }else if(pcb->group_leader != NULL){
+            type = "thread";
+        }else{
+            type = "process";
+        }
+        vfile_printf(vf, "%5d %5d %c %3u %4d %8u %8u %-7s %s\n", pid, pcb->parent_id,
+                     task_state(pcb), pcb->terminal_num, pcb->slot, pcb->sched_ticks,
+                     pcb->sched_switches, type, pcb->name);
+    }
+}
+
+/* void procfs_sched(vfile_t* vf)
+ * Inputs: vfile_t* vf -- read in progress
+ * Return Value: none
+ * Function: text of "sched", the counters then one line per slot of schedule_array */
+static void procfs_sched(vfile_t* vf){
+    pcb_struct* pcb;
+    int32_t slot;
+
+    vfile_printf(vf, "uptime_ms    %u\n", div_u64(clock_ns(), NS_PER_MS, NULL));
+    vfile_printf(vf, "pit_hz       %u\n", PIT_HZ);
+    vfile_printf(vf, "pit_ticks    %u\n", pit_ticks);
+    vfile_printf(vf, "switches     %u\n", sched_switches);
+    vfile_printf(vf, "all_blocked  %u\n", sched_all_blocked);
+    vfile_printf(vf, "running      %d\n", current_pcb()->pid);
+    vfile_printf(vf, "SLOT ROLE     PID S NAME\n");
+    for(slot = 0; slot < SCHEDULE_SLOTS; slot++){
+        if(slot <= SCHEDULED_TASKS_NUM){
+            vfile_printf(vf, "%4d tty%-4u", slot, slot);
+        }else{
+            vfile_printf(vf, "%4d %-7s", slot, (slot < KTHREAD_SLOT_BASE) ? "spawn" : "kthread");
+        }
+        pcb = (schedule_array[slot] == SLOT_FREE) ? NULL : task_pcb(schedule_array[slot]);
+        if(pcb == NULL){
+            vfile_printf(vf, "    - -\n");
+            continue;
+        }
+        vfile_printf(vf, " %4d %c %s\n", pcb->pid, task_state(pcb), pcb->name);
+    }
+}
+
+/* void procfs_interrupts(vfile_t* vf)
+ * Inputs: vfile_t* vf -- read in progress
+ * Return Value: none
+ * Function: text of "interrupts", the IRQs and exceptions taken at least once, then the
+ *           softirq accounting */
+static void procfs_interrupts(vfile_t* vf){
+    softirq_stat_t* s;
+    uint32_t idx;
+
+    vfile_printf(vf, "IRQ      COUNT NAME\n");
+    for(idx = 0; idx < NUM_IRQS; idx++){
+        if(irq_counts[idx] == 0) continue;
+        vfile_printf(vf, "%3u %10u %s\n", idx, irq_counts[idx],
+                     (irq_names[idx] != NULL) ? irq_names[idx] : "-");
+    }
+    vfile_printf(vf, "VEC      COUNT NAME\n");
+    for(idx = 0; idx < NUM_EXCEPTIONS; idx++){
+        if(exc_counts[idx] == 0) continue;
+        vfile_printf(vf, "%3u %10u %s\n", idx, exc_counts[idx], exc_names[idx]);
+    }
+    vfile_printf(vf, "SOFTIRQ      RAISED       RUNS   TASKLETS AVG_CYCLES MAX_CYCLES\n");
+    for(idx = 0; idx < NUM_SOFTIRQS; idx++){
+        s = &softirq_stats[idx];
+        vfile_printf(vf, "%-8s %10u %10u %10u %10u %10u\n", softirq_names[idx], s->raised,
+                     s->runs, s->tasklets, avg_cycles(s->cycles, s->runs), s->max_cycles);
+    }
+    vfile_printf(vf, "syscalls     %u\n", sysstat_total());
+    vfile_printf(vf, "kbd_dropped  %u\n", scan_dropped);
+}
+
+/* void procfs_meminfo(vfile_t* vf)
+ * Inputs: vfile_t* vf -- read in progress
+ * Return Value: none
+ * Function: text of "meminfo". Every task has an 8KB kernel stack below 8MB, every program a
+ *           4MB page from 8MB up that its threads share, and shared memory and pipe buffers
+ *           are in the kernel image. */
+static void procfs_meminfo(vfile_t* vf){
+    pcb_struct* pcb;
+    uint32_t tasks = 0, programs = 0;
+    uint32_t shm_segs, shm_pages, pipes, queued;
+    int32_t pid;
+
+    for(pid = 0; pid < MAX_TASKS; pid++){
+        pcb = task_pcb(pid);
+        if(pcb == NULL) continue;
+        tasks++;
+        if(!pcb->kthread && pcb->group_leader == NULL) programs++;
+    }
+    shm_usage(&shm_segs, &shm_pages);
+    pipe_usage(&pipes, &queued);
+
+    vfile_printf(vf, "KernelImage:  %8u kB\n", ((uint32_t)_end - FOUR_MB) / KB);
+    vfile_printf(vf, "Tasks:        %8u of %u\n", tasks, MAX_TASKS);
+    vfile_printf(vf, "KernelStacks: %8u kB\n", tasks * (EIGHT_KB / KB));
+    vfile_printf(vf, "Programs:     %8u\n", programs);
+    vfile_printf(vf, "ProgramPages: %8u kB\n", programs * (FOUR_MB / KB));
+    vfile_printf(vf, "ShmSegments:  %8u of %u\n", shm_segs, SHM_MAX_SEGS);
+    vfile_printf(vf, "ShmUsed:      %8u kB\n", shm_pages * (SHM_PAGE_SIZE / KB));
+    vfile_printf(vf, "ShmPool:      %8u kB\n", SHM_MAX_SEGS * (SHM_SEG_SIZE / KB));
+    vfile_printf(vf, "Pipes:        %8u of %u\n", pipes, PIPE_MAX);
+    vfile_printf(vf, "PipeBuffers:  %8u kB\n", pipes * (PIPE_BUF_SIZE / KB));
+    vfile_printf(vf, "PipeQueued:   %8u B\n", queued);
+}
+
+/* void procfs_terminals(vfile_t* vf)
+ * Inputs: vfile_t* vf -- read in progress
+ * Return Value: none
+ * Function: text of "terminals", one line per terminal, * marks the one on the screen. LINE
+ *           is the characters typed and not read, RAW the key events queued in raw mode. */
+static void procfs_terminals(vfile_t* vf){
+    pcb_struct* pcb;
+    int32_t term;
+
+    vfile_printf(vf, "TTY SHOWN   PID MODE    LINE  RAW NAME\n");
+    for(term = 0; term < NUM_TERMINALS; term++){
+        vfile_printf(vf, "%3d %-5s ", term, (term == terminal_num) ? "*" : "");
+        pcb = (pit_count > term) ? task_pcb(terminal[term].curr_pid) : NULL;
+        if(pcb == NULL){
+            vfile_printf(vf, "    - -\n");      // shell not started yet
+            continue;
+        }
+        vfile_printf(vf, "%5d %-7s %4u %4u %s\n", pcb->pid, mode_names[terminal_mode(term) & TERM_MODE_MASK],
+                     terminal[term].buffer_ct, terminal[term].raw_tail - terminal[term].raw_head,
+                     pcb->name);
+    }
+}
@@ -0,0 +1,19 @@
+/* procfs.h - synthetic files whose text is generated on every read */
+
+#ifndef _PROCFS_H
+#define _PROCFS_H
+
+#include "types.h"
+#include "filesys.h"
+
+uint32_t procfs_count(void);
+uint32_t procfs_dentry_by_name(const uint8_t* fname, dentry_t* dentry);
+uint32_t procfs_dentry_by_index(uint32_t index, dentry_t* dentry);
+
+/* files of type PROC_FILE_TYPE, the inode is the index in procfs_files */
+int32_t procfs_open(const uint8_t* filename);
+int32_t procfs_close(int32_t fd);
+int32_t procfs_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t procfs_write(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif /* _PROCFS_H */
@@ -0,0 +1,189 @@
+/* prof.c - sampling profiler
+ * While profile() has it running, every RTC interrupt (1024 Hz, divided down to the rate asked
+ * for) records where the CPU was: eip, cs, the pid and program name of the running task, and
+ * the return addresses found by following the saved ebp chain within the stack it interrupted.
+ * The kernel and the programs are built without -fomit-frame-pointer, so the chain is there.
+ * Samples go in a fixed ring, the oldest are overwritten, and read back as text lines through
+ * the virtual file "profile":
+ *     <pid> <name> <k|u> <eip> <caller> <caller's caller> ...
+ * with the addresses in hex. Reading the file on the serial terminal sends it to the host,
+ * where prof_symbolize.py turns it into flame graph input.
+ */
+
+#include "prof.h"
+#include "lib.h"
+#include "rtc.h"
+#include "system_call.h"
+#include "thread.h"
+#include "timer.h"
+#include "x86_desc.h"
+
+#define CPL_MASK    3
+
+static prof_sample_t prof_ring[PROF_SAMPLES];
+static volatile uint32_t prof_head = 0;         // samples taken since the last start
+static uint32_t prof_period = 0;                // RTC ticks between samples, 0 while stopped
+static uint32_t prof_countdown = 0;
+static int8_t prof_names[PROF_NAMES][DENTRY_FILE_NAME_LEN + 1];
+static uint32_t num_names = 0;
+uint32_t prof_lost_names = 0;                   // samples whose name did not fit the table
+
+fop_table_t prof_fop = {
+    prof_open,
+    prof_close,
+    prof_read,
+    prof_write
+};
+
+/* uint32_t prof_name(pcb_struct* pcb)
+ * Inputs: pcb_struct* pcb -- running task
+ * Return Value: index of its program name in prof_names
+ * Function: looks the name up, adding it if it is new. A thread goes by its program's name,
+ *           and the last entry takes every name once the table is full. */
+static uint32_t prof_name(pcb_struct* pcb){
+    const int8_t* name = (const int8_t*)group_leader(pcb)->name;
+    uint32_t idx;
+
+    if(*name == '\0') name = "kernel";         // boot code before the first shell
+    for(idx = 0; idx < num_names; idx++){
+        if(!strncmp(prof_names[idx], name, DENTRY_FILE_NAME_LEN)) return idx;
+    }
+    if(num_names == PROF_NAMES){
+        prof_lost_names++;
+        return PROF_NAMES - 1;
+    }
+    strncpy(prof_names[num_names], name, DENTRY_FILE_NAME_LEN);
+    prof_names[num_names][DENTRY_FILE_NAME_LEN] = '\0';
+    return num_names++;
+}
+
+/* void prof_tick(hw_context_t* regs)
+ * Inputs: hw_context_t* regs -- registers saved by the RTC interrupt
+ * Return Value: none
+ * Function: takes a sample every prof_period ticks, called from the RTC top half with
+ *           interrupts disabled. The ebp chain is only followed while it stays inside the
+ *           interrupted stack, the kernel stack holding regs or the program's 4MB page, and
+ *           moves up it, so a corrupt or missing frame pointer ends the chain. */
+void prof_tick(hw_context_t* regs){
+    prof_sample_t* s;
+    uint32_t lo, hi, ebp, next, depth;
+
+    if(prof_period == 0 || --prof_countdown != 0) return;
+    prof_countdown = prof_period;
+
+    s = &prof_ring[prof_head & (PROF_SAMPLES - 1)];
+    s->pc[0] = regs->eip;
+    s->cs = regs->cs;
+    s->pid = current_pcb()->pid;
+    s->name = prof_name(current_pcb());
+    if((regs->cs & CPL_MASK) == 0){
+        lo = (uint32_t)regs;
+        hi = (lo | (EIGHT_KB - 1)) + 1;
+    }else{
+        lo = USER_ADDR;
+        hi = ONE_THIRTY_TWO_MB;
+    }
+    ebp = regs->ebp;
+    for(depth = 1; depth < PROF_DEPTH; depth++){
+        if(ebp < lo || ebp > hi - 2 * sizeof(uint32_t) || (ebp & (sizeof(uint32_t) - 1))) break;
+        s->pc[depth] = ((uint32_t*)ebp)[1];     // return address above the saved ebp
+        next = ((uint32_t*)ebp)[0];
+        ebp = (next > ebp) ? next : 0;          // the callers' frames are further up
+    }
+    for(; depth < PROF_DEPTH; depth++){
+        s->pc[depth] = 0;
+    }
+    prof_head++;
+}
+
+/* int32_t profile(int32_t hz)
+ * Inputs: int32_t hz -- samples per second, a power of two up to 1024, or 0 to stop
+ * Return Value: 0 on success, -1 for a bad rate
+ * Function: system call, starts the profiler with an empty ring or stops it. The samples of
+ *           a stopped run stay readable until the next start. */
+int32_t profile(int32_t hz){
+    uint32_t flags;
+
+    if(hz < 0 || hz > MAX_FREQUENCY || (hz & (hz - 1))) return FAIL_NEG_ONE;
+    cli_and_save(flags);
+    if(hz == 0){
+        prof_period = 0;
+    }else{
+        prof_head = 0;
+        num_names = 0;
+        prof_lost_names = 0;
+        prof_period = MAX_FREQUENCY / hz;
+        prof_countdown = prof_period;
+    }
+    restore_flags(flags);
+    return 0;
+}
+
+/* int32_t prof_open(const uint8_t* filename)
+ * Inputs: const uint8_t* filename -- "profile"
+ * Return Value: file descriptor, -1 if none is free
+ * Function: opens the samples for reading from the oldest still in the ring */
+int32_t prof_open(const uint8_t* filename){
+    uint32_t oldest = (prof_head > PROF_SAMPLES) ? prof_head - PROF_SAMPLES : 0;
+    return alloc_fd(&prof_fop, 0, oldest);
+}
+
+/* int32_t prof_close(int32_t fd)
+ * Inputs: int32_t fd -- file descriptor
+ * Return Value: 0
+ * Function: releases the descriptor */
+int32_t prof_close(int32_t fd){
+    files_pcb()->file_descriptor[fd].flags = 0;
+    return 0;
+}
+
+/* int32_t prof_read(int32_t fd, void* buf, int32_t nbytes)
+ * Inputs: int32_t fd -- file descriptor
+ *         void* buf -- user buffer
+ *         int32_t nbytes -- its size
+ * Return Value: bytes read, 0 once every sample has been read
+ * Function: formats whole samples as lines. The file position is the number of the next
+ *           sample, samples overwritten before they are read are skipped. Reading while the
+ *           profiler runs works, stopping it first gives a consistent set. */
+int32_t prof_read(int32_t fd, void* buf, int32_t nbytes){
+    pcb_struct* pcb = files_pcb();
+    uint32_t pos = pcb->file_descriptor[fd].file_position;
+    uint8_t* out = (uint8_t*)buf;
+    int8_t line[PROF_LINE_LEN];
+    int32_t count = 0;
+    uint32_t len, depth;
+    prof_sample_t* s;
+
+    if(pos > prof_head) pos = 0;                // the profiler was restarted
+    for(; pos != prof_head; pos++){
+        if(prof_head - pos > PROF_SAMPLES){
+            pos = prof_head - PROF_SAMPLES;
+        }
+        s = &prof_ring[pos & (PROF_SAMPLES - 1)];
+        len = snprintf(line, sizeof(line), "%u %s %c %x", s->pid, prof_names[s->name],
+                       (s->cs & CPL_MASK) ? 'u' : 'k', s->pc[0]);
+        for(depth = 1; depth < PROF_DEPTH && s->pc[depth] != 0; depth++){
+            len += snprintf(line + len, sizeof(line) - len, " %x", s->pc[depth]);
+        }
+        len += snprintf(line + len, sizeof(line) - len, "\n");
+        if(len >= sizeof(line)) len = sizeof(line) - 1;
+        if(count + len > nbytes){
+            if(count > 0) break;                // whole lines only
+            len = nbytes;                       // buffer smaller than one line, give what fits
+        }
+        memcpy(out + count, line, len);
+        count += len;
+    }
+    pcb->file_descriptor[fd].file_position = pos;
+    return count;
+}
+
+/* int32_t prof_write(int32_t fd, const void* buf, int32_t nbytes)
+ * Inputs: int32_t fd -- file descriptor
+ *         const void* buf -- ignored
+ *         int32_t nbytes -- ignored
+ * Return Value: -1
+ * Function: the samples are read-only, profile() starts and stops the profiler */
+int32_t prof_write(int32_t fd, const void* buf, int32_t nbytes){
+    return -1;
+}
@@ -0,0 +1,32 @@
+/* prof.h - sampling profiler */
+
+#ifndef _PROF_H
+#define _PROF_H
+
+#include "types.h"
+#include "signal.h"
+
+#define PROF_SAMPLES    4096    // ring size, must be a power of two
+#define PROF_DEPTH      8       // eip and the return addresses after it kept per sample
+#define PROF_NAMES      16      // program names told apart in one run
+#define PROF_LINE_LEN   (16 + 32 + PROF_DEPTH * 9)  // pid, name, mode and addresses of one line
+
+typedef struct prof_sample_t {
+    uint32_t pc[PROF_DEPTH];    // eip, then return addresses, 0 past the end of the chain
+    uint16_t cs;
+    uint16_t pid;
+    uint32_t name;              // index in the name table
+} prof_sample_t;
+
+void prof_tick(hw_context_t* regs);
+
+/* system call */
+int32_t profile(int32_t hz);
+
+/* virtual file "profile" */
+int32_t prof_open(const uint8_t* filename);
+int32_t prof_close(int32_t fd);
+int32_t prof_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t prof_write(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif /* _PROF_H */
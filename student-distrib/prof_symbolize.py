@@ -0,0 +1,107 @@
+#!/usr/bin/env python3
+"""Turn the kernel profiler's samples into flame graph input.
+
+Start the profiler in the OS with "prof <hz>", run the workload, stop it with
+"prof stop" and save the output of "cat profile" (the serial terminal is the
+easy way to get it to the host). Each line of it is
+
+    <pid> <name> <k|u> <eip> <return address> ...
+
+This script looks the addresses up in the kernel ELF (bootimg) for kernel
+mode samples and in the unconverted program ELF (syscalls/<name>.exe,
+fish/fish.exe) for user mode ones, and prints one folded stack per line:
+
+    name;outer_function;...;leaf_function count
+
+Kernel functions carry a _[k] suffix, which flamegraph.pl colors apart:
+
+    ./prof_symbolize.py samples.txt | flamegraph.pl > profile.svg
+"""
+
+import argparse
+import bisect
+import collections
+import os
+import subprocess
+import sys
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+
+
+class Symbols:
+    """Function symbols of one ELF, from nm."""
+
+    def __init__(self, path):
+        self.addrs = []
+        self.names = []
+        out = subprocess.run(["nm", "-n", "--defined-only", path],
+                             capture_output=True, text=True, check=True).stdout
+        for line in out.splitlines():
+            fields = line.split()
+            if len(fields) == 3 and fields[1] in "TtWw":
+                self.addrs.append(int(fields[0], 16))
+                self.names.append(fields[2])
+
+    def lookup(self, addr):
+        i = bisect.bisect_right(self.addrs, addr) - 1
+        return self.names[i] if i >= 0 else None
+
+
+def find_program(name, dirs):
+    for d in dirs:
+        for candidate in (name + ".exe", name):
+            path = os.path.join(d, candidate)
+            if os.path.isfile(path):
+                return path
+    return None
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("samples", nargs="?", type=argparse.FileType("r"),
+                        default=sys.stdin, help="output of cat profile")
+    parser.add_argument("--kernel", default=os.path.join(HERE, "bootimg"),
+                        help="kernel ELF (default: bootimg next to this script)")
+    parser.add_argument("--bin", action="append", default=[],
+                        help="directory with program ELFs, may repeat")
+    args = parser.parse_args()
+
+    dirs = args.bin or [os.path.join(HERE, "..", "syscalls"),
+                        os.path.join(HERE, "..", "fish")]
+    kernel = Symbols(args.kernel)
+    programs = {}
+    stacks = collections.Counter()
+
+    for line in args.samples:
+        fields = line.split()
+        if len(fields) < 4 or fields[2] not in ("k", "u"):
+            continue                    # shell prompt or other output around the dump
+        try:
+            int(fields[0])              # pid, pids are reused so the name groups samples
+            pcs = [int(f, 16) for f in fields[3:]]
+        except ValueError:
+            continue
+        name, mode = fields[1], fields[2]
+        if mode == "k":
+            symbols, suffix = kernel, "_[k]"
+        else:
+            if name not in programs:
+                path = find_program(name, dirs)
+                programs[name] = Symbols(path) if path else None
+                if path is None:
+                    print("no ELF found for %s" % name, file=sys.stderr)
+            symbols, suffix = programs[name], ""
+        frames = []
+        for depth, pc in enumerate(pcs):
+            # return addresses point after the call, look up the call itself
+            func = symbols.lookup(pc if depth == 0 else pc - 1) if symbols else None
+            frames.append((func or "0x%x" % pc) + suffix)
+        frames.append(name)
+        stacks[";".join(reversed(frames))] += 1
+
+    for stack, count in sorted(stacks.items()):
+        print("%s %d" % (stack, count))
+
+
+if __name__ == "__main__":
+    main()
@@ -6,13 +6,23 @@
 #include "i8259.h"
 #include "system_call.h"
 #include "scheduling.h"
+#include "softirq.h"
+#include "timer.h"
+#include "poll.h"
+#include "thread.h"
 
-uint32_t desired_virtualized_frequency[3] = {2, 2, 2};
-// uint32_t interrupt_flag = 1;
-// uint32_t interrupt_count = 0;
-uint32_t rtc_idx = 0;
-uint32_t interrupt_flag[3] = {1, 1, 1};
-uint32_t interrupt_count[3] = {0, 0, 0};
+volatile uint32_t rtc_pending_ticks = 0;    // ticks taken by the top half, not yet counted
+volatile uint32_t rtc_jiffies = 0;          // 1024 Hz ticks counted by the bottom half
+
+/* Virtual timers, one per open RTC file descriptor (fd.inode is the index). They sit on a two
+ * level timer wheel: level 0 has a slot per tick for the next RTC_WHEEL_SIZE ticks, level 1 a
+ * slot per RTC_WHEEL_SIZE ticks beyond that. A tick only visits the timers that expire on it,
+ * plus one level 1 slot every RTC_WHEEL_SIZE ticks whose timers move down to level 0. */
+rtc_timer_t rtc_timers[RTC_MAX_TIMERS];
+static rtc_timer_t* rtc_wheel[RTC_WHEEL_LEVELS][RTC_WHEEL_SIZE];
+
+static void rtc_timer_add(rtc_timer_t* timer);
+static void rtc_timer_del(rtc_timer_t* timer);
 
 /* void rtc_init()
  * Initialize the RTC
@@ -46,8 +56,12 @@ void rtc_init() {
     /* Re-enable NMI */
     outb(inb(INDEX_PORT) & MASK_MOST_SIG_BIT, INDEX_PORT);
 
-    // Initial virtualized frequency
-    desired_virtualized_frequency[schedule_idx] = 2; //2hz
+    // No virtual timers yet
+    memset(rtc_timers, 0, sizeof(rtc_timers));
+    memset(rtc_wheel, 0, sizeof(rtc_wheel));
+    rtc_jiffies = 0;
+
+    open_softirq(SOFTIRQ_RTC, rtc_bottom_half);
 
     // /* Enable RTC interrupts */
     enable_irq(RTC_PIC_PIN);
@@ -58,36 +72,42 @@ void rtc_init() {
 }
 
 /* void rtc_read()
- * Read function returns after an interrupt has occured
- * inputs: none
- * outputs: always return 0
- * side effects: set interrupt_flag that will be changed by rtc_write
+ * Read function returns after the virtual timer of fd has fired
+ * inputs:  fd      -     file descriptor
+ * outputs: 0 once the timer fired, -1 if a signal arrived first
+ * side effects: consumes the ticks of the timer, returns at once if it fired since the last read,
+ *               otherwise blocks until the RTC softirq wakes it
  */
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
+    pcb_struct* pcb = current_pcb();
+    rtc_timer_t* timer = &rtc_timers[files_pcb()->file_descriptor[fd].inode];
+
     cli();
-    while(1){
-        cli();
-        // disable_irq(0);
-        if(interrupt_flag[schedule_idx] == 1){
+    while(timer->fired == 0){
+        timer->waiter = pcb;
+        if(block_current(TIMER_NO_DEADLINE) == -1){
+            timer->waiter = NULL;
             sti();
-            // enable_irq(0);
-        }else{
-            break;
+            return -1;
         }
-    }  
-    // while(interrupt_flag == 1){
-    //     //wait until interrupt handler clears it
-    // }
-    // while(interrupt_flag[schedule_idx] == 1){
-    //     //wait until interrupt handler clears it
-    // }
-    // interrupt_flag = 1;
-    interrupt_flag[schedule_idx] = 1;
+    }
+    timer->waiter = NULL;
+    timer->fired = 0;
     sti();
-    // enable_irq(0);
     return 0;
 }
 
+/* int32_t rtc_poll()
+ * readiness of an RTC file
+ * inputs:  fd      -     file descriptor
+ * outputs: POLLIN if the virtual timer of fd fired since the last read, and POLLOUT
+ * side effects: none
+ */
+int32_t rtc_poll(int32_t fd){
+    rtc_timer_t* timer = &rtc_timers[files_pcb()->file_descriptor[fd].inode];
+
+    return (timer->fired ? POLLIN : 0) | POLLOUT;
+}
 
 /* void rtc_write()
  * Accept only a 4-byte integer specifying the interrupt rate in Hz, and should set the rate of periodic interrupts accordingly.
@@ -96,19 +116,29 @@ int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes){
  *          nbytes  -     number of bytes used in the buffer
  * outputs: -1      -     invalid frequency
  *          0       -     success
- * side effects: clear interrupt_flag that will be read by rtc_read
+ * side effects: restarts the virtual timer of fd with a period of MAX_FREQUENCY/rate ticks
  */
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes){ 
-    cli();
-    if(nbytes != 4) return -1;
+    pcb_struct* pcb = files_pcb();
+    rtc_timer_t* timer;
+    uint32_t flags;
+
+    if(nbytes != 4 || buf == NULL) return -1;
     int32_t interrupt_rate = *((int32_t*)buf);
 
     // Should limit this further to 1024 Hz and should be a power of 2
     if(interrupt_rate > MAX_FREQUENCY || interrupt_rate <= 0 || !((interrupt_rate != 0) && ((interrupt_rate & (interrupt_rate - 1)) == 0))){
         return -1;
     }
-    desired_virtualized_frequency[schedule_idx] = interrupt_rate;
-    sti();
+
+    cli_and_save(flags);
+    timer = &rtc_timers[pcb->file_descriptor[fd].inode];
+    rtc_timer_del(timer);
+    timer->period = MAX_FREQUENCY / interrupt_rate;     // exact, both are powers of 2
+    timer->expires = rtc_jiffies + timer->period;
+    timer->fired = 0;
+    rtc_timer_add(timer);
+    restore_flags(flags);
     
     return 0;
 }
@@ -117,61 +147,43 @@ int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes){
  * Open a file for RTC
  * inputs:  fd      -     file descriptor
  *          filename-     name of the rtc file
- * outputs: -1      -     invalid name or file type or fd
- *          0       -     success
- * side effects: set file descriptor flag to 1
+ * outputs: -1      -     invalid name or file type, or no fd or virtual timer free
+ *          fd      -     success
+ * side effects: set file descriptor flag to 1, starts a 2 Hz virtual timer for the fd
  */
 int32_t rtc_open(const uint8_t* filename){
-    cli();
-    // disable_irq(0);
-    desired_virtualized_frequency[schedule_idx] = 2;
-    interrupt_count[schedule_idx] = 0;
-    interrupt_flag[schedule_idx] = 1;
-    // interrupt_count = 0;
-    // interrupt_flag = 1;
-    
     dentry_t dentry;
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[schedule_idx].curr_pid +1));   
-    // pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    uint32_t idx, flags;
+    int32_t fd;
 
-    int i;
-    int32_t fd = -1;   //invalid fd (used if all fd slots are open/unavailable)  
-
-    for(i = FD_MIN; i <= FD_MAX; i++){     //Find an open slot in the fd
-        if(pcb->file_descriptor[i].flags == 0){
-            fd = i;
-            break;
-        }
-    }
-
-    if((fd == -1) || fd < FD_MIN || fd > FD_MAX){ // invalid descriptor (none existing, stdin, stdout)
-        // enable_irq(0);
-        sti();
-        return -1;
-    }
     if(read_dentry_by_name(filename, &dentry) == -1){ // If the named file does not exist
-        // enable_irq(0);
-        sti();
         return -1; 
     }
     if(dentry.file_type != RTC_FILE_TYPE){ // If wrong file type
-        // enable_irq(0);
-        sti();
         return -1;
     }
 
-    if(pcb->file_descriptor[fd].flags == 0){
-        pcb->file_descriptor[fd].file_operations_table_pointer = &rtc_fop;
-        pcb->file_descriptor[fd].inode = 0; // 0 for directories and RTC
-        pcb->file_descriptor[fd].file_position = 0; // starts at the initial position
-        pcb->file_descriptor[fd].flags = 1; // descriptor in-use
-    }else{
-        // enable_irq(0);
-        sti();
-        return -1; // descriptor is not free
+    cli_and_save(flags);
+    for(idx = 0; idx < RTC_MAX_TIMERS; idx++){     // find a free virtual timer
+        if(!rtc_timers[idx].in_use){
+            break;
+        }
     }
-    // enable_irq(0);
-    sti();
+    if(idx == RTC_MAX_TIMERS){
+        restore_flags(flags);
+        return -1;
+    }
+    fd = alloc_fd(&rtc_fop, idx, 0);    // inode is the virtual timer
+    if(fd == -1){
+        restore_flags(flags);
+        return -1;
+    }
+    rtc_timers[idx].in_use = 1;
+    rtc_timers[idx].period = MAX_FREQUENCY / RTC_DEFAULT_RATE;
+    rtc_timers[idx].expires = rtc_jiffies + rtc_timers[idx].period;
+    rtc_timers[idx].fired = 0;
+    rtc_timer_add(&rtc_timers[idx]);
+    restore_flags(flags);
     return fd;
 }
 
@@ -180,51 +192,142 @@ int32_t rtc_open(const uint8_t* filename){
  * inputs:  fd      -     file descriptor
  * outputs: -1      -     invalid fd
  *          0       -     success
- * side effects: set file descriptor flag to 0
+ * side effects: set file descriptor flag to 0, stops and frees the virtual timer
  */
 int32_t rtc_close(int32_t fd){
-    cli();
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[schedule_idx].curr_pid +1));   
-    // pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));
+    pcb_struct* pcb = files_pcb();   
+    rtc_timer_t* timer;
+    uint32_t flags;
 
     if(fd < FD_MIN || fd > FD_MAX){ // invalid descriptor (none existing, stdin, stdout)
-        sti();
         return -1;
     }
     
+    cli_and_save(flags);
     if(pcb->file_descriptor[fd].flags == 1){
+        timer = &rtc_timers[pcb->file_descriptor[fd].inode];
+        rtc_timer_del(timer);
+        timer->in_use = 0;
+        timer->waiter = NULL;
         pcb->file_descriptor[fd].flags = 0; // descriptor not used
     }else{
         // Do nothing, descriptor is free already
     }
-    sti();
+    restore_flags(flags);
     return 0;
 }
 
-/* void rtc_handler()
- * handler for the RTC
- * inputs: none
+/* void rtc_timer_add()
+ * puts a timer on the wheel by its expiry, called with interrupts disabled
+ * inputs: rtc_timer_t* timer -- timer with expires set, no more than RTC_MAX_DELAY ticks ahead
  * outputs: none
- * side effects: increments video memory every time it recieves an RTC interrupt
+ * side effects: links the timer at the head of its slot
  */
-void rtc_handler(){
-    // disable_irq(0);
-    cli();
-    interrupt_count[rtc_idx]++;
-    if(rtc_idx < 2){
-        rtc_idx++;
+static void rtc_timer_add(rtc_timer_t* timer){
+    uint32_t delta = timer->expires - rtc_jiffies;
+    rtc_timer_t** slot;
+
+    if(delta < RTC_WHEEL_SIZE){
+        slot = &rtc_wheel[0][timer->expires & RTC_WHEEL_MASK];
     }else{
-        rtc_idx = 0;
+        slot = &rtc_wheel[1][(timer->expires >> RTC_WHEEL_BITS) & RTC_WHEEL_MASK];
     }
-    
-    // interrupt_count++;
-    if(interrupt_count[schedule_idx] >= MAX_FREQUENCY/(desired_virtualized_frequency[schedule_idx]*3)){
-        interrupt_flag[schedule_idx] = 0;
-        interrupt_count[schedule_idx] = 0;
+    timer->slot = slot;
+    timer->prev = NULL;
+    timer->next = *slot;
+    if(*slot != NULL){
+        (*slot)->prev = timer;
+    }
+    *slot = timer;
+}
+
+/* void rtc_timer_del()
+ * takes a timer off the wheel, called with interrupts disabled
+ * inputs: rtc_timer_t* timer -- timer, may already be off the wheel
+ * outputs: none
+ * side effects: unlinks the timer in O(1)
+ */
+static void rtc_timer_del(rtc_timer_t* timer){
+    if(timer->slot == NULL){
+        return;
     }
+    if(timer->prev != NULL){
+        timer->prev->next = timer->next;
+    }else{
+        *(timer->slot) = timer->next;
+    }
+    if(timer->next != NULL){
+        timer->next->prev = timer->prev;
+    }
+    timer->slot = NULL;
+    timer->next = NULL;
+    timer->prev = NULL;
+}
+
+/* void rtc_tick()
+ * advances the wheel by one tick, called with interrupts disabled
+ * inputs: none
+ * outputs: none
+ * side effects: moves due level 1 timers down, fires and re-arms the timers expiring now
+ */
+static void rtc_tick(){
+    rtc_timer_t* timer;
+    rtc_timer_t* next;
+
+    rtc_jiffies++;
+    if((rtc_jiffies & RTC_WHEEL_MASK) == 0){    // a level 1 slot comes due, spread it over level 0
+        timer = rtc_wheel[1][(rtc_jiffies >> RTC_WHEEL_BITS) & RTC_WHEEL_MASK];
+        rtc_wheel[1][(rtc_jiffies >> RTC_WHEEL_BITS) & RTC_WHEEL_MASK] = NULL;
+        while(timer != NULL){
+            next = timer->next;
+            timer->slot = NULL;
+            rtc_timer_add(timer);
+            timer = next;
+        }
+    }
+
+    timer = rtc_wheel[0][rtc_jiffies & RTC_WHEEL_MASK];
+    rtc_wheel[0][rtc_jiffies & RTC_WHEEL_MASK] = NULL;
+    while(timer != NULL){
+        next = timer->next;
+        timer->slot = NULL;
+        timer->fired++;
+        if(timer->waiter != NULL){
+            wake_process((pcb_struct*)timer->waiter);
+        }
+        poll_notify();
+        timer->expires += timer->period;
+        rtc_timer_add(timer);
+        timer = next;
+    }
+}
+
+/* void rtc_handler()
+ * handler for the RTC (top half)
+ * inputs: none
+ * outputs: none
+ * side effects: acknowledges the interrupt and leaves the tick for rtc_bottom_half
+ */
+void rtc_handler(){
     outb(C_REG, INDEX_PORT);	// select register C
     inb(CMOS_PORT);		        // just throw away contents
-    // enable_irq(0);
-    sti();
+    rtc_pending_ticks++;
+    raise_softirq(SOFTIRQ_RTC);
 }
 
+/* void rtc_bottom_half()
+ * RTC softirq
+ * inputs: none
+ * outputs: none
+ * side effects: advances the timer wheel by every tick taken since the last run
+ */
+void rtc_bottom_half(){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    while(rtc_pending_ticks){        // a burst of ticks is handled in one run
+        rtc_pending_ticks--;
+        rtc_tick();
+    }
+    restore_flags(flags);
+}
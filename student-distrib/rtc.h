@@ -1,4 +1,7 @@
 /* rtc.h: defining the functions dealing with the Real-Time Clock */
+#ifndef _RTC_H
+#define _RTC_H
+
 #include "types.h"
 
 #define INDEX_PORT 0x70
@@ -14,12 +17,34 @@
 #define ASCII_ZERO 48
 #define ASCII_NINE 57
 #define MAX_FREQUENCY 1024
+#define RTC_DEFAULT_RATE    2       // Hz, rate of a newly opened RTC file
+
+#define RTC_MAX_TIMERS      64      // open RTC files across all processes
+#define RTC_WHEEL_LEVELS    2
+#define RTC_WHEEL_BITS      6
+#define RTC_WHEEL_SIZE      (1 << RTC_WHEEL_BITS)
+#define RTC_WHEEL_MASK      (RTC_WHEEL_SIZE - 1)
+#define RTC_MAX_DELAY       ((RTC_WHEEL_SIZE - 1) * RTC_WHEEL_SIZE)  // ticks, longer than the 1 Hz period
+
+/* virtual periodic timer behind an open RTC file */
+typedef struct rtc_timer_t {
+    uint32_t in_use;
+    uint32_t period;                // ticks between expiries, MAX_FREQUENCY/rate
+    uint32_t expires;               // tick of the next expiry
+    volatile uint32_t fired;        // expiries not yet consumed by rtc_read
+    void* waiter;                   // PCB blocked in rtc_read, NULL if none
+    struct rtc_timer_t* next;       // wheel slot list
+    struct rtc_timer_t* prev;
+    struct rtc_timer_t** slot;      // slot the timer is linked in, NULL when off the wheel
+} rtc_timer_t;
 
 void rtc_init(void);
 void rtc_handler(void);
+void rtc_bottom_half(void);
 int32_t rtc_read(int32_t fd, void* buf, int32_t nbytes);
 int32_t rtc_write(int32_t fd, const void* buf, int32_t nbytes);
+int32_t rtc_poll(int32_t fd);
 int32_t rtc_open(const uint8_t* filename);
 int32_t rtc_close(int32_t fd);
 
-
+#endif /* _RTC_H */
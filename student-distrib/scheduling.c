@@ -3,6 +3,9 @@
 #include "x86_desc.h"
 #include "i8259.h"
 #include "keyboard.h"
+#include "vdso.h"
+#include "shm.h"
+#include "thread.h"
 
 #define PIT_PIC_PIN 0
 
@@ -10,8 +13,76 @@ uint32_t i = 1;
 pcb_struct* pcb_scheduling;
 uint32_t curr_esp_scheduling;
 uint32_t curr_ebp_scheduling;
+uint32_t tries;
+int32_t first_pos;
 
 
+/* void scheduler_init()
+ * Inputs: none
+ * Outputs: none
+ * Return Value: none
+ * Function: empties the background and kernel thread slots, the terminal slots fill as the
+ *           shells start
+ * */
+void scheduler_init(){
+    int32_t slot;
+    schedule_idx = 0;
+    schedule_pos = 0;
+    for(slot = SCHEDULED_TASKS_NUM+1; slot < SCHEDULE_SLOTS; slot++){
+        schedule_array[slot] = SLOT_FREE;
+    }
+}
+
+/* int32_t alloc_background_slot()
+ * Inputs: none
+ * Outputs: none
+ * Return Value: a free background slot, -1 if all are taken
+ * Function: finds a slot for a process started by spawn, the caller fills it
+ * */
+int32_t alloc_background_slot(){
+    int32_t slot;
+    for(slot = SCHEDULED_TASKS_NUM+1; slot < KTHREAD_SLOT_BASE; slot++){
+        if(schedule_array[slot] == SLOT_FREE){
+            return slot;
+        }
+    }
+    return -1;
+}
+
+/* int32_t alloc_kthread_slot()
+ * Inputs: none
+ * Outputs: none
+ * Return Value: a free kernel thread slot, -1 if all are taken
+ * Function: finds a slot for a kernel thread, the caller fills it
+ * */
+int32_t alloc_kthread_slot(){
+    int32_t slot;
+    for(slot = KTHREAD_SLOT_BASE; slot < SCHEDULE_SLOTS; slot++){
+        if(schedule_array[slot] == SLOT_FREE){
+            return slot;
+        }
+    }
+    return -1;
+}
+
+/* void schedule_exit()
+ * Inputs: none
+ * Outputs: none
+ * Return Value: does not return
+ * Function: leaves a task that has already freed its slot. Once the three shells run, the
+ *           scheduler switches to the next task at once and never comes back to the free
+ *           slot, so the dead task's kernel stack is left right away. Before that, the task
+ *           waits for the PIT tick. Called with interrupts disabled.
+ * */
+void schedule_exit(){
+    if(pit_count > SCHEDULED_TASKS_NUM+1){
+        scheduler();
+    }
+    while(1){
+        asm volatile ("sti; hlt; cli" : : : "memory");
+    }
+}
+
 /* void scheduler()
  * Inputs: none
  * Outputs: none
@@ -65,21 +136,45 @@ void scheduler(){
             pcb_scheduling->parent_id = -1;
             pcb_scheduling->active = 1;
             pit_count++;
+            schedule_pos = schedule_idx;
         }
 
-        //Increment the scheduler process idx that represents which terminal is being actively running
-        if(schedule_idx < SCHEDULED_TASKS_NUM){
-            schedule_idx++;
-        }else{
-            schedule_idx = 0;
+        //Move to the next slot, the terminals and then the background processes, passing over
+        //free slots and blocked processes unless every process is blocked
+        first_pos = -1;
+        for(tries = 0; tries < SCHEDULE_SLOTS; tries++){
+            if(schedule_pos < SCHEDULE_SLOTS-1){
+                schedule_pos++;
+            }else{
+                schedule_pos = 0;
+            }
+            if(schedule_array[schedule_pos] == SLOT_FREE){
+                continue;
+            }
+            if(first_pos == -1){
+                first_pos = schedule_pos;
+            }
+            if(((pcb_struct*)(EIGHT_MB - EIGHT_KB*(schedule_array[schedule_pos]+1)))->state != PROC_BLOCKED){
+                break;
+            }
+        }
+        if(tries == SCHEDULE_SLOTS){
+            schedule_pos = first_pos;
+            sched_all_blocked++;
         }
 
-        //Get the pid: Get scheduler process idx -> access scheduler struct array with that idx to get the next pid
-        uint32_t next_pid = schedule_array[schedule_idx];
+        //Get the pid: Get scheduler slot -> access scheduler struct array with that slot to get the next pid
+        uint32_t next_pid = schedule_array[schedule_pos];
         process_num = next_pid;
 
-        //Find PCB of the next process 
+        //Find PCB of the next process, the terminal index follows it
         pcb_struct* next_process_pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(next_pid+1));
+        schedule_idx = next_process_pcb->terminal_num;
+        pcb_scheduling->sched_ticks++;      // the tick ran the task it preempts
+        if(next_process_pcb != pcb_scheduling){
+            sched_switches++;
+            next_process_pcb->sched_switches++;
+        }
         
         // Set up the page table entry for switching between video memories for different process
         pt_entry_page vidmap_table_entry;
@@ -119,6 +214,7 @@ void scheduler(){
                 vidmap_page_table[i] = vidmap_table_entry.val;
             }
         }
+        vidmap_page_table[VDSO_PT_IDX] = vdso_pte();   // time page stays mapped for every process
 
         // Set up the 4kb page directory entry to switch to
         pd_entry_pt vid_mem_pt;
@@ -136,13 +232,47 @@ void scheduler(){
         page_dir[ONE_THIRTY_TWO_MB/FOUR_MB] = vid_mem_pt.val;
         flush_tlb();
         
-        //Setup paging for the next process + Flush TLB 
-        paging_execute(next_process_pcb->pid);
+        //Setup paging for the next process + Flush TLB, a thread runs in its leader's page
+        shm_switch(group_leader(next_process_pcb));
+        paging_execute(group_leader(next_process_pcb)->pid);
+        fpu_switch(next_process_pcb);
 
         //Switch the kernel stack to the next process’s kernel stack (from next process’s PCB)
         //Restore next process’ TSS
         tss.ss0 = KERNEL_DS; //pointer to kernel’s stack segment
         tss.esp0 = EIGHT_MB - EIGHT_KB*(next_process_pcb->pid) - FOUR_BYTES; // restore parent's kernel-mode stack
+
+        //A spawned process, thread or kernel thread has no saved context yet, enter its program
+        //or thread function on an empty kernel stack
+        if(next_process_pcb->fresh){
+            next_process_pcb->fresh = 0;
+            send_eoi(PIT_PIC_PIN);
+            if(next_process_pcb->kthread){
+                asm volatile ("movl %0, %%esp;\n\
+                                call kthread_start;"
+                                :                /* output */
+                                :"r"(tss.esp0)   /* input */
+                                :"memory"        /* clobbered register */
+                                );
+            }
+            if(next_process_pcb->group_leader != NULL){
+                asm volatile ("movl %0, %%esp;\n\
+                                pushl %2;\n\
+                                pushl %1;\n\
+                                call thread_switch;"
+                                :                /* output */
+                                :"r"(tss.esp0), "r"(next_process_pcb->entry_point), "r"(next_process_pcb->user_esp)  /* input */
+                                :"memory"        /* clobbered register */
+                                );
+            }
+            asm volatile ("movl %0, %%esp;\n\
+                            pushl %1;\n\
+                            call context_switch;"
+                            :                /* output */
+                            :"r"(tss.esp0), "r"(next_process_pcb->entry_point)  /* input */
+                            :"memory"        /* clobbered register */
+                            );
+        }
         asm volatile ("movl %0, %%esp;"
                         :                /* output */
                         :"r"(next_process_pcb->saved_esp)  /* input */
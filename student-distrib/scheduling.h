@@ -4,11 +4,24 @@
 
 #include "types.h"
 #define SCHEDULED_TASKS_NUM 2
+#define BACKGROUND_SLOTS    4                                   // processes started by spawn
+#define KTHREAD_SLOTS       2                                   // kernel threads
+#define SCHEDULE_SLOTS      (SCHEDULED_TASKS_NUM + 1 + BACKGROUND_SLOTS + KTHREAD_SLOTS)
+#define KTHREAD_SLOT_BASE   (SCHEDULE_SLOTS - KTHREAD_SLOTS)
+#define SLOT_FREE           -1
 
 void scheduler(void);
+void schedule_exit(void);
+void scheduler_init(void);
+int32_t alloc_background_slot(void);
+int32_t alloc_kthread_slot(void);
 
-volatile int32_t schedule_idx;
+volatile int32_t schedule_idx;      // terminal of the running process
 int32_t pit_count;
-int32_t schedule_array[SCHEDULED_TASKS_NUM+1];
+int32_t schedule_pos;               // slot of the running process
+uint32_t sched_switches;            // PIT ticks that switched to a different task
+uint32_t sched_all_blocked;         // PIT ticks that found every task blocked
+// pid running from each slot: one per terminal, then the background and kernel thread slots
+int32_t schedule_array[SCHEDULE_SLOTS];
 
 #endif 
@@ -0,0 +1,217 @@
+/* serial.c: functions dealing with the COM1 16550 UART
+ * COM1 is a second console for terminal 0. Everything printed on terminal 0 is copied to it,
+ * lines typed on it are read by terminal 0 like keyboard lines, and it is a kernel log sink.
+ * Output is queued in a TX ring and written a FIFO at a time from the TX empty interrupt.
+ */
+
+#include "serial.h"
+#include "lib.h"
+#include "i8259.h"
+#include "softirq.h"
+#include "klog.h"
+#include "keyboard.h"
+#include "poll.h"
+
+static uint8_t tx_ring[SERIAL_TX_SIZE];
+static volatile uint32_t tx_head = 0;       // next byte for the UART, written by the handler
+static volatile uint32_t tx_tail = 0;       // next free slot, written by serial_putc
+static uint8_t rx_ring[SERIAL_RX_SIZE];
+static volatile uint32_t rx_head = 0;       // written by the bottom half
+static volatile uint32_t rx_tail = 0;       // written by the handler
+static volatile uint32_t tx_running = 0;    // TX empty interrupt enabled
+static uint32_t serial_present = 0;
+
+void serial_bottom_half(void);
+void serial_klog_sink(const int8_t* text, uint32_t len);
+
+/* void serial_init()
+ * Initialize COM1
+ * inputs: none
+ * outputs: none
+ * side effects: sets 115200 8N1 with FIFOs, enables the RX interrupt and IRQ4 and adds a
+ *               kernel log sink. Does nothing if no UART answers the loopback test.
+ */
+void serial_init(){
+    uint32_t flags;
+    cli_and_save(flags);
+
+    outb(0x00, COM1_PORT + SERIAL_IER);                     // no interrupts while programming
+    outb(LCR_DLAB, COM1_PORT + SERIAL_LCR);
+    outb(SERIAL_DIVISOR & 0xFF, COM1_PORT + SERIAL_DATA);
+    outb(SERIAL_DIVISOR >> 8, COM1_PORT + SERIAL_IER);
+    outb(LCR_8N1, COM1_PORT + SERIAL_LCR);
+    outb(FCR_ENABLE_CLEAR_14, COM1_PORT + SERIAL_FCR);
+
+    // loopback probe, a missing UART reads back 0xFF
+    outb(MCR_LOOPBACK, COM1_PORT + SERIAL_MCR);
+    outb(SERIAL_PROBE_BYTE, COM1_PORT + SERIAL_DATA);
+    if(inb(COM1_PORT + SERIAL_DATA) != SERIAL_PROBE_BYTE){
+        serial_present = 0;
+        restore_flags(flags);
+        return;
+    }
+    outb(MCR_DTR_RTS_OUT2, COM1_PORT + SERIAL_MCR);
+    serial_present = 1;
+
+    open_softirq(SOFTIRQ_SERIAL, serial_bottom_half);
+    outb(IER_RX_AVAIL, COM1_PORT + SERIAL_IER);
+    enable_irq(SERIAL_IRQ_NUM);
+    restore_flags(flags);
+
+    klog_add_sink(serial_klog_sink, KLOG_DEBUG);
+}
+
+/* int32_t serial_is_present()
+ * inputs: none
+ * outputs: 1 if serial_init found a UART, 0 otherwise
+ * side effects: none
+ */
+int32_t serial_is_present(){
+    return serial_present;
+}
+
+/* void serial_queue(uint8_t c)
+ * puts one byte in the TX ring, called with interrupts disabled
+ * inputs: uint8_t c -- byte to send
+ * outputs: none
+ * side effects: when the ring is full, writes the oldest byte by polling so no output is lost
+ */
+static void serial_queue(uint8_t c){
+    if(tx_tail - tx_head >= SERIAL_TX_SIZE){
+        while(!(inb(COM1_PORT + SERIAL_LSR) & LSR_TX_EMPTY));
+        outb(tx_ring[tx_head & (SERIAL_TX_SIZE - 1)], COM1_PORT + SERIAL_DATA);
+        tx_head++;
+    }
+    tx_ring[tx_tail & (SERIAL_TX_SIZE - 1)] = c;
+    tx_tail++;
+}
+
+/* void serial_putc(uint8_t c)
+ * queues a character for COM1
+ * inputs: uint8_t c -- character, '\n' is sent as CR LF and '\b' erases the last character
+ * outputs: none
+ * side effects: enables the TX empty interrupt if the transmitter is idle
+ */
+void serial_putc(uint8_t c){
+    uint32_t flags;
+    if(!serial_present){
+        return;
+    }
+    cli_and_save(flags);
+    if(c == '\n'){
+        serial_queue('\r');
+        serial_queue('\n');
+    }else if(c == '\b'){
+        serial_queue('\b');
+        serial_queue(' ');
+        serial_queue('\b');
+    }else{
+        serial_queue(c);
+    }
+    if(!tx_running){
+        tx_running = 1;
+        outb(IER_RX_AVAIL | IER_TX_EMPTY, COM1_PORT + SERIAL_IER);   // fires at once if THR is empty
+    }
+    restore_flags(flags);
+}
+
+/* void serial_handler()
+ * interrupt handler for COM1 (top half)
+ * inputs: none
+ * outputs: none
+ * side effects: refills the TX FIFO, moves received bytes to the RX ring and raises the serial
+ *               softirq for them
+ */
+void serial_handler(){
+    uint8_t iir;
+    uint32_t count;
+    uint32_t received = 0;
+
+    while(!((iir = inb(COM1_PORT + SERIAL_IIR)) & IIR_NO_INT)){
+        switch(iir & IIR_ID_MASK){
+        case IIR_TX_EMPTY:
+            for(count = 0; count < SERIAL_FIFO_LEN && tx_head != tx_tail; count++){
+                outb(tx_ring[tx_head & (SERIAL_TX_SIZE - 1)], COM1_PORT + SERIAL_DATA);
+                tx_head++;
+            }
+            if(tx_head == tx_tail){
+                tx_running = 0;
+                outb(IER_RX_AVAIL, COM1_PORT + SERIAL_IER);
+            }
+            break;
+        case IIR_RX_AVAIL:
+        case IIR_RX_TIMEOUT:
+            while(inb(COM1_PORT + SERIAL_LSR) & LSR_RX_READY){
+                uint8_t c = inb(COM1_PORT + SERIAL_DATA);
+                if(rx_tail - rx_head < SERIAL_RX_SIZE){
+                    rx_ring[rx_tail & (SERIAL_RX_SIZE - 1)] = c;
+                    rx_tail++;
+                }
+                received = 1;
+            }
+            break;
+        case IIR_LINE:
+            inb(COM1_PORT + SERIAL_LSR);
+            break;
+        default:        // modem status
+            inb(COM1_PORT + SERIAL_MSR);
+            break;
+        }
+    }
+    if(received){
+        raise_softirq(SOFTIRQ_SERIAL);
+    }
+}
+
+/* void serial_bottom_half()
+ * serial softirq, line editing for input typed on COM1
+ * inputs: none
+ * outputs: none
+ * side effects: adds received characters to the line buffer of SERIAL_TERMINAL and echoes them
+ *               on COM1, CR or LF completes the line for terminal_read
+ */
+void serial_bottom_half(){
+    terminal_storage* term = &terminal[SERIAL_TERMINAL];
+    uint8_t c;
+    uint32_t flags;
+
+    while(rx_head != rx_tail){
+        c = rx_ring[rx_head & (SERIAL_RX_SIZE - 1)];
+        rx_head++;
+
+        cli_and_save(flags);        // the keyboard bottom half edits the same line
+        if(term->enter_read){
+            // previous line not read yet, drop input like the keyboard does
+        }else if(c == '\r' || c == '\n'){
+            term->enter_read = 1;
+            serial_putc('\n');
+        }else if(c == '\b' || c == ASCII_DEL){
+            if(term->buffer_ct != 0){
+                term->buffer_ct--;
+                term->keyboard_buffer[term->buffer_ct] = NULL;
+                serial_putc('\b');
+            }
+        }else if(c >= ' ' && c < ASCII_DEL && term->buffer_ct < (BUFFER_LIM - 1)){
+            term->keyboard_buffer[term->buffer_ct] = c;
+            term->buffer_ct++;
+            serial_putc(c);
+        }
+        restore_flags(flags);
+    }
+    poll_notify();
+}
+
+/* void serial_klog_sink(const int8_t* text, uint32_t len)
+ * kernel log sink
+ * inputs: const int8_t* text -- record text
+ *         uint32_t len -- its length
+ * outputs: none
+ * side effects: writes the record to COM1
+ */
+void serial_klog_sink(const int8_t* text, uint32_t len){
+    uint32_t j;
+    for(j = 0; j < len; j++){
+        serial_putc(text[j]);
+    }
+    serial_putc('\n');
+}
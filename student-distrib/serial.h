@@ -0,0 +1,53 @@
+/* serial.h: defining the functions dealing with the COM1 16550 UART */
+
+#ifndef _SERIAL_H
+#define _SERIAL_H
+
+#include "types.h"
+
+#define COM1_PORT           0x3F8
+#define SERIAL_IRQ_NUM      4
+
+/* register offsets from COM1_PORT */
+#define SERIAL_DATA         0   // RX/TX buffer, divisor low byte when DLAB is set
+#define SERIAL_IER          1   // interrupt enable, divisor high byte when DLAB is set
+#define SERIAL_IIR          2   // interrupt identification (read)
+#define SERIAL_FCR          2   // FIFO control (write)
+#define SERIAL_LCR          3
+#define SERIAL_MCR          4
+#define SERIAL_LSR          5
+#define SERIAL_MSR          6
+
+#define IER_RX_AVAIL        0x01
+#define IER_TX_EMPTY        0x02
+#define IIR_NO_INT          0x01
+#define IIR_ID_MASK         0x0E
+#define IIR_MODEM           0x00
+#define IIR_TX_EMPTY        0x02
+#define IIR_RX_AVAIL        0x04
+#define IIR_LINE            0x06
+#define IIR_RX_TIMEOUT      0x0C
+#define LCR_DLAB            0x80
+#define LCR_8N1             0x03
+#define FCR_ENABLE_CLEAR_14 0xC7    // enable and clear both FIFOs, RX interrupt at 14 bytes
+#define MCR_DTR_RTS_OUT2    0x0B    // OUT2 gates the UART interrupt onto the PIC
+#define MCR_LOOPBACK        0x1E
+#define LSR_RX_READY        0x01
+#define LSR_TX_EMPTY        0x20
+
+#define SERIAL_DIVISOR      1       // 115200 baud
+#define SERIAL_PROBE_BYTE   0xAE
+#define SERIAL_FIFO_LEN     16      // bytes written per TX interrupt
+#define SERIAL_TX_SIZE      2048    // power of 2
+#define SERIAL_RX_SIZE      256     // power of 2
+
+#define SERIAL_TERMINAL     0       // terminal mirrored on COM1 and fed by its input
+
+#define ASCII_DEL           0x7F
+
+void serial_init(void);
+void serial_handler(void);
+void serial_putc(uint8_t c);
+int32_t serial_is_present(void);
+
+#endif /* _SERIAL_H */
@@ -0,0 +1,300 @@
+/* shm.c: named shared memory segments
+ * A segment is a run of 4KB pages from a pool in the kernel image. Every segment owns a
+ * fixed window of the 4MB region at SHM_ADDR, mapped through shm_page_table, so a segment
+ * has the same address in every process that attaches it. The table holds the segments of
+ * the running process (the leader's for a thread) and is rebuilt when the scheduler
+ * switches to a process with a different set. Every process that got or attached a segment
+ * holds one reference on it, and the segment lives until the last of them detaches or halts.
+ * Freed segments are zeroed by a job on the kworker thread rather than by the system call
+ * that frees or creates them.
+ */
+
+#include "shm.h"
+#include "lib.h"
+#include "paging.h"
+#include "system_call.h"
+#include "timer.h"
+#include "kthread.h"
+#include "thread.h"
+
+static uint8_t shm_pool[SHM_MAX_SEGS][SHM_SEG_SIZE] __attribute__((aligned (SHM_PAGE_SIZE)));
+static uint32_t shm_page_table[KB] __attribute__((aligned (FOUR_KB)));
+static shm_seg_t shm_segs[SHM_MAX_SEGS];
+static uint32_t shm_mapped;                 // segments shm_page_table holds right now
+static tasklet_t shm_scrub_work;            // shm_scrub on the kworker thread
+
+static void shm_scrub(uint32_t data);
+
+/* void shm_init(void)
+ * inputs: none
+ * outputs: none
+ * Function: empties the segment table and points the page directory entry for SHM_ADDR at
+ *           the (still empty) shared page table
+ */
+void shm_init(void){
+    pd_entry_pt shm_pt;
+
+    memset(shm_segs, 0, sizeof(shm_segs));
+    memset(shm_page_table, 0, sizeof(shm_page_table));
+    shm_scrub_work.func = shm_scrub;
+    shm_scrub_work.data = 0;
+    shm_scrub_work.scheduled = 0;
+    shm_mapped = 0;
+
+    shm_pt.val             = 0;
+    shm_pt.page_base_31_12 = ((uint32_t)shm_page_table/FOUR_KB);
+    shm_pt.page_size       = 0; // 0 for page table page directory entry
+    shm_pt.u_s             = 1; // user level
+    shm_pt.r_w             = 1; // 1 for read/write
+    shm_pt.present         = 1; // PDE does exist, the page table entries decide
+    page_dir[SHM_ADDR >> 22] = shm_pt.val;
+    flush_tlb();
+}
+
+/* void shm_switch(pcb_struct* pcb)
+ * inputs: pcb -- process about to run, or the current one after its set changed
+ * outputs: none
+ * Function: maps exactly the segments attached by pcb. Switching between processes with the
+ *           same set leaves the table and the TLB alone.
+ */
+void shm_switch(pcb_struct* pcb){
+    pt_entry_page entry;
+    uint32_t seg, page, pages;
+
+    if(pcb->shm_attached == shm_mapped){
+        return;
+    }
+    for(seg = 0; seg < SHM_MAX_SEGS; seg++){
+        pages = 0;
+        if(pcb->shm_attached & (1 << seg)){
+            pages = (shm_segs[seg].size + SHM_PAGE_SIZE - 1) / SHM_PAGE_SIZE;
+        }
+        for(page = 0; page < SHM_SEG_PAGES; page++){
+            entry.val = 0;
+            if(page < pages){
+                entry.present = 1;
+                entry.r_w = 1;
+                entry.u_s = 1;
+                entry.page_base_31_12 = (uint32_t)&shm_pool[seg][page * SHM_PAGE_SIZE] / FOUR_KB;
+            }
+            shm_page_table[seg * SHM_SEG_PAGES + page] = entry.val;
+        }
+    }
+    shm_mapped = pcb->shm_attached;
+    flush_tlb();
+}
+
+/* static void shm_hold(pcb_struct* pcb, int32_t id)
+ * inputs: pcb -- process taking the reference, the leader for a thread
+ *         id -- segment in use
+ * outputs: none
+ * Function: takes the process's reference on the segment, once however often it asks.
+ *           Called with interrupts disabled.
+ */
+static void shm_hold(pcb_struct* pcb, int32_t id){
+    if(!(pcb->shm_held & (1 << id))){
+        pcb->shm_held |= 1 << id;
+        shm_segs[id].refs++;
+    }
+}
+
+/* int32_t shm_find_or_create(const uint8_t* name, uint32_t size)
+ * inputs: name -- kernel copy of the segment name
+ *         size -- bytes needed, at most SHM_SEG_SIZE
+ * outputs: segment id, -1 if the size is bad, an existing segment is smaller or none is free
+ * Function: finds the segment called name, creating it zero filled if nobody has, and holds
+ *           it for the current process until shm_detach or halt, so a segment that is never
+ *           attached is still freed. A free segment the kworker has not zeroed yet is zeroed
+ *           here.
+ */
+int32_t shm_find_or_create(const uint8_t* name, uint32_t size){
+    pcb_struct* pcb = files_pcb();
+    uint32_t flags;
+    int32_t seg, free_seg = -1;
+
+    if(size == 0 || size > SHM_SEG_SIZE || name[0] == '\0'){
+        return FAIL_NEG_ONE;
+    }
+    cli_and_save(flags);
+    for(seg = 0; seg < SHM_MAX_SEGS; seg++){
+        if(!shm_segs[seg].in_use){
+            if(free_seg == -1){
+                free_seg = seg;
+            }
+        }else if(strncmp((const int8_t*)shm_segs[seg].name, (const int8_t*)name, SHM_NAME_LEN) == 0){
+            if(size > shm_segs[seg].size){
+                restore_flags(flags);
+                return FAIL_NEG_ONE;
+            }
+            shm_hold(pcb, seg);
+            restore_flags(flags);
+            return seg;
+        }
+    }
+    if(free_seg != -1){
+        shm_segs[free_seg].in_use = 1;
+        shm_segs[free_seg].size = size;
+        shm_segs[free_seg].refs = 0;
+        strncpy((int8_t*)shm_segs[free_seg].name, (const int8_t*)name, SHM_NAME_LEN - 1);
+        shm_segs[free_seg].name[SHM_NAME_LEN - 1] = '\0';
+        if(shm_segs[free_seg].dirty){
+            memset(shm_pool[free_seg], 0, SHM_SEG_SIZE);
+            shm_segs[free_seg].dirty = 0;
+        }
+        shm_hold(pcb, free_seg);
+    }
+    restore_flags(flags);
+    return free_seg;
+}
+
+/* uint8_t* shm_map(int32_t id)
+ * inputs: id -- segment from shm_find_or_create
+ * outputs: user address of the segment, NULL if there is no such segment
+ * Function: attaches the segment to the current process, attaching twice is harmless
+ */
+uint8_t* shm_map(int32_t id){
+    pcb_struct* pcb = files_pcb();
+    uint32_t flags;
+
+    if(id < 0 || id >= SHM_MAX_SEGS){
+        return NULL;
+    }
+    cli_and_save(flags);
+    if(!shm_segs[id].in_use){
+        restore_flags(flags);
+        return NULL;
+    }
+    if(!(pcb->shm_attached & (1 << id))){
+        pcb->shm_attached |= 1 << id;
+        shm_hold(pcb, id);
+        shm_switch(pcb);
+    }
+    restore_flags(flags);
+    return (uint8_t*)(SHM_ADDR + id * SHM_SEG_SIZE);
+}
+
+/* int32_t shm_detach(int32_t id)
+ * inputs: id -- segment got or attached by the current process
+ * outputs: 0 on success, -1 if the process does not hold it
+ * Function: system call, unmaps the segment, drops the process's reference and frees it
+ *           when nobody else holds it
+ */
+int32_t shm_detach(int32_t id){
+    pcb_struct* pcb = files_pcb();
+    uint32_t flags;
+
+    if(id < 0 || id >= SHM_MAX_SEGS){
+        return FAIL_NEG_ONE;
+    }
+    cli_and_save(flags);
+    if(!(pcb->shm_held & (1 << id))){
+        restore_flags(flags);
+        return FAIL_NEG_ONE;
+    }
+    pcb->shm_attached &= ~(1 << id);
+    pcb->shm_held &= ~(1 << id);
+    if(--shm_segs[id].refs == 0){
+        shm_segs[id].in_use = 0;
+        shm_segs[id].dirty = 1;
+        kworker_queue(&shm_scrub_work);
+    }
+    shm_switch(pcb);
+    restore_flags(flags);
+    return 0;
+}
+
+/* void shm_scrub(uint32_t data)
+ * inputs: data -- unused
+ * outputs: none
+ * Function: kworker job, zeroes the freed segments. A segment is zeroed with interrupts
+ *           disabled so it cannot be handed out half cleared.
+ */
+static void shm_scrub(uint32_t data){
+    uint32_t flags;
+    int32_t seg;
+
+    for(seg = 0; seg < SHM_MAX_SEGS; seg++){
+        cli_and_save(flags);
+        if(!shm_segs[seg].in_use && shm_segs[seg].dirty){
+            memset(shm_pool[seg], 0, SHM_SEG_SIZE);
+            shm_segs[seg].dirty = 0;
+        }
+        restore_flags(flags);
+    }
+}
+
+/* void shm_detach_all(pcb_struct* pcb)
+ * inputs: pcb -- halting process, the one running
+ * outputs: none
+ * Function: drops every segment the process still holds, attached or not
+ */
+void shm_detach_all(pcb_struct* pcb){
+    int32_t id;
+
+    for(id = 0; id < SHM_MAX_SEGS; id++){
+        if(pcb->shm_held & (1 << id)){
+            shm_detach(id);
+        }
+    }
+}
+
+/* void shm_usage(uint32_t* segs, uint32_t* pages)
+ * inputs: segs -- set to the segments in use
+ *         pages -- set to the pool pages they take
+ * outputs: none
+ * Function: memory statistics for procfs.c
+ */
+void shm_usage(uint32_t* segs, uint32_t* pages){
+    int32_t id;
+
+    *segs = 0;
+    *pages = 0;
+    for(id = 0; id < SHM_MAX_SEGS; id++){
+        if(shm_segs[id].in_use){
+            (*segs)++;
+            *pages += (shm_segs[id].size + SHM_PAGE_SIZE - 1) / SHM_PAGE_SIZE;
+        }
+    }
+}
+
+/* int32_t shm_get(const uint8_t* name, uint32_t size)
+ * Inputs: name -- NUL terminated name in the user page, shorter than SHM_NAME_LEN
+ *         size -- bytes needed
+ * Return Value: segment id, -1 on a bad name or size or when the table is full
+ *  Function: system call, looks up or creates a named segment. The segment is not mapped
+ *            until shm_attach, but the process holds it from here, so it is freed by
+ *            shm_detach or at halt even if it was never attached. */
+int32_t shm_get(const uint8_t* name, uint32_t size){
+    uint8_t kname[SHM_NAME_LEN];
+    uint32_t i;
+
+    if(!user_buffer_ok(name, 1)){
+        return FAIL_NEG_ONE;
+    }
+    for(i = 0; i < SHM_NAME_LEN && user_buffer_ok(&name[i], 1); i++){
+        kname[i] = name[i];
+        if(kname[i] == '\0'){
+            return shm_find_or_create(kname, size);
+        }
+    }
+    return FAIL_NEG_ONE;                    // too long or runs off the page
+}
+
+/* int32_t shm_attach(int32_t id, uint8_t** addr)
+ * Inputs: id -- segment from shm_get
+ *         addr -- where to store the address of the segment, in the user page
+ * Return Value: 0 on success, -1 on a bad pointer or segment
+ *  Function: system call, maps the segment into the calling process */
+int32_t shm_attach(int32_t id, uint8_t** addr){
+    uint8_t* seg;
+
+    if(!user_buffer_ok(addr, sizeof(uint8_t*))){
+        return FAIL_NEG_ONE;
+    }
+    seg = shm_map(id);
+    if(seg == NULL){
+        return FAIL_NEG_ONE;
+    }
+    *addr = seg;
+    return 0;
+}
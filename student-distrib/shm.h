@@ -0,0 +1,36 @@
+/* shm.h: named shared memory segments */
+
+#ifndef _SHM_H
+#define _SHM_H
+
+#include "types.h"
+#include "filesys.h"
+
+#define SHM_MAX_SEGS    8                               // at most 32 bits, one per bit of pcb->shm_attached
+#define SHM_SEG_PAGES   8
+#define SHM_PAGE_SIZE   4096
+#define SHM_SEG_SIZE    (SHM_SEG_PAGES * SHM_PAGE_SIZE) // largest segment, 32KB
+#define SHM_NAME_LEN    32                              // including the terminating NUL
+#define SHM_ADDR        0x8800000                       // 136MB, segment i is mapped at SHM_ADDR + i * SHM_SEG_SIZE
+
+typedef struct shm_seg_t {
+    uint32_t in_use;
+    uint32_t size;                                      // bytes asked for at creation
+    uint32_t refs;                                      // processes that hold it, from shm_get or shm_attach
+    uint32_t dirty;                                     // freed and not zeroed yet
+    uint8_t name[SHM_NAME_LEN];
+} shm_seg_t;
+
+void shm_init(void);
+int32_t shm_find_or_create(const uint8_t* name, uint32_t size);
+uint8_t* shm_map(int32_t id);
+void shm_switch(pcb_struct* pcb);
+void shm_detach_all(pcb_struct* pcb);
+void shm_usage(uint32_t* segs, uint32_t* pages);
+
+/* system calls */
+int32_t shm_get(const uint8_t* name, uint32_t size);
+int32_t shm_attach(int32_t id, uint8_t** addr);
+int32_t shm_detach(int32_t id);
+
+#endif /* _SHM_H */
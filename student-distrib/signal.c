@@ -0,0 +1,197 @@
+/* signal.c: signals delivered to user programs on their way back to user mode
+ * Every interrupt, exception and system call leaves through ret_from_intr in intr_linkage.S,
+ * which calls do_signal with the saved registers. If the program is returning to user mode
+ * with a pending signal that is not blocked, do_signal pushes a sig_frame_t on the user
+ * stack and points the saved eip at the handler, so the iret enters the handler instead.
+ * The handler returns into a small trampoline in the frame that calls sigreturn, which
+ * copies the saved registers back. All signals are blocked while a handler runs.
+ * A signal that will be acted on wakes its target if it is blocked, and the blocking system
+ * calls give up with -1 when they see it, so it is delivered on the way out.
+ */
+
+#include "signal.h"
+#include "lib.h"
+#include "x86_desc.h"
+#include "filesys.h"
+#include "system_call.h"
+#include "scheduling.h"
+#include "idt_number.h"
+#include "idt_handler.h"
+#include "timer.h"
+#include "pit.h"
+
+/* movl $SIGRETURN_NUM, %eax; int $0x80; nop */
+static const uint8_t sigreturn_code[8] = {0xB8, SIGRETURN_NUM, 0x00, 0x00, 0x00, 0xCD, 0x80, 0x90};
+
+static uint32_t alarm_ticks = 0;
+
+/* void send_signal(pcb_struct* pcb, int32_t signum)
+ * inputs: pcb -- process to signal
+ *         signum -- SIG_* number
+ * outputs: none
+ * Function: marks the signal pending, it is delivered the next time the process returns to
+ *           user mode. A process blocked in a system call is woken so the call can return.
+ *           Safe from interrupt context.
+ */
+void send_signal(pcb_struct* pcb, int32_t signum){
+    uint32_t flags;
+
+    if(signum < 0 || signum >= NUM_SIGNALS){
+        return;
+    }
+    cli_and_save(flags);
+    pcb->sig_pending |= 1 << signum;
+    if(signal_pending(pcb) && pcb->state == PROC_BLOCKED){
+        wake_process(pcb);
+        pcb->sig_woken = 1;
+    }
+    restore_flags(flags);
+}
+
+/* int32_t signal_pending(pcb_struct* pcb)
+ * inputs: pcb -- task to check
+ * outputs: 1 if a signal is pending that is not blocked and that do_signal would act on, by
+ *          running a handler or killing the program, else 0
+ * Function: tells a blocking system call to give up with -1. Ignored signals do not count.
+ */
+int32_t signal_pending(pcb_struct* pcb){
+    uint32_t ready = pcb->sig_pending & ~pcb->sig_blocked;
+    int32_t signum;
+
+    for(signum = 0; signum < NUM_SIGNALS; signum++){
+        if((ready & (1 << signum)) && (pcb->sig_handler[signum] != 0 || (SIG_DEFAULT_KILL & (1 << signum)))){
+            return 1;
+        }
+    }
+    return 0;
+}
+
+/* int32_t signal_from_exception(int32_t intr_num, hw_context_t* regs)
+ * inputs: intr_num -- exception vector
+ *         regs -- registers saved by the exception linkage
+ * outputs: 1 if the exception was turned into a signal for a handler, 0 if the caller
+ *          should fall back to killing the process
+ * Function: a divide error raises SIG_DIV_ZERO and any other fault of a user program raises
+ *           SIG_SEGFAULT, but only when the program handles that signal and is not already
+ *           inside a handler
+ */
+int32_t signal_from_exception(int32_t intr_num, hw_context_t* regs){
+    pcb_struct* pcb;
+    int32_t signum = (intr_num == div_by_zero) ? SIG_DIV_ZERO : SIG_SEGFAULT;
+
+    if((regs->cs & 3) != 3 || intr_num == nmi || intr_num == double_fault || intr_num == machine){
+        return 0;
+    }
+    pcb = current_pcb();
+    if(pcb->sig_handler[signum] == 0 || (pcb->sig_blocked & (1 << signum))){
+        return 0;
+    }
+    send_signal(pcb, signum);
+    return 1;
+}
+
+/* int32_t do_signal(hw_context_t* regs)
+ * inputs: regs -- registers the linkage is about to restore
+ * outputs: 1 if regs now enter a handler, 0 if they are unchanged
+ * Function: delivers the lowest pending signal that is not blocked. Signals without a
+ *           handler are ignored or kill the process, see SIG_DEFAULT_KILL. Called with
+ *           interrupts disabled.
+ */
+int32_t do_signal(hw_context_t* regs){
+    pcb_struct* pcb;
+    sig_frame_t* frame;
+    uint32_t ready;
+    int32_t signum;
+
+    if((regs->cs & 3) != 3){
+        return 0;                       // back to the kernel, deliver later
+    }
+    pcb = current_pcb();
+    while((ready = pcb->sig_pending & ~pcb->sig_blocked) != 0){
+        for(signum = 0; !(ready & (1 << signum)); signum++);
+        pcb->sig_pending &= ~(1 << signum);
+        if(pcb->sig_handler[signum] == 0){
+            if(SIG_DEFAULT_KILL & (1 << signum)){
+                exception_halt(EXEC_STATUS);
+            }
+            continue;
+        }
+
+        frame = (sig_frame_t*)((regs->esp - sizeof(sig_frame_t)) & ~(sizeof(uint32_t) - 1));
+        if(!user_buffer_ok(frame, sizeof(sig_frame_t))){
+            exception_halt(EXEC_STATUS);    // no room on the user stack
+        }
+        frame->ret_addr = (uint32_t)frame->trampoline;
+        frame->signum = signum;
+        frame->context = *regs;
+        frame->blocked = pcb->sig_blocked;
+        memcpy(frame->trampoline, sigreturn_code, sizeof(sigreturn_code));
+        pcb->sig_blocked = SIG_ALL;
+
+        regs->esp = (uint32_t)frame;
+        regs->eip = pcb->sig_handler[signum];
+        return 1;
+    }
+    return 0;
+}
+
+/* void signal_alarm_tick(void)
+ * inputs: none
+ * outputs: none
+ * Function: called on every PIT tick from the timer softirq, sends SIG_ALARM to the
+ *           foreground program of the visible terminal every ALARM_PERIOD_SEC seconds
+ */
+void signal_alarm_tick(void){
+    if(++alarm_ticks < ALARM_PERIOD_SEC * PIT_HZ){
+        return;
+    }
+    alarm_ticks = 0;
+    if(pit_count > terminal_num){       // its shell is running
+        send_signal((pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[terminal_num].curr_pid+1)), SIG_ALARM);
+    }
+}
+
+/* int32_t set_handler(int32_t signum, void* handler_address)
+ * Inputs: int32_t signum -- SIG_* number
+ *         void* handler_address -- user function taking the signal number, NULL for the
+ *                                  default action
+ * Return Value: 0 on success, -1 on a bad signal number or handler address
+ * Function: system call, installs the handler of the calling process */
+int32_t set_handler(int32_t signum, void* handler_address){
+    if(signum < 0 || signum >= NUM_SIGNALS){
+        return FAIL_NEG_ONE;
+    }
+    if(handler_address != NULL && !user_buffer_ok(handler_address, 1)){
+        return FAIL_NEG_ONE;
+    }
+    current_pcb()->sig_handler[signum] = (uint32_t)handler_address;
+    return 0;
+}
+
+/* int32_t sigreturn(void)
+ * Inputs: none, reached from the trampoline with esp just above the frame's ret_addr
+ * Return Value: the eax of the interrupted program, so the linkage restores it; -1 if the
+ *               user stack holds no frame
+ * Function: system call, restores the registers and the blocked mask saved by do_signal.
+ *           Segment registers and the privileged eflags bits are not taken from the user. */
+int32_t sigreturn(void){
+    hw_context_t* regs = (hw_context_t*)(tss.esp0 - sizeof(hw_context_t));   // frame of this call
+    sig_frame_t* frame = (sig_frame_t*)(regs->esp - sizeof(uint32_t));         // ret_addr was popped
+    hw_context_t* saved;
+
+    if(!user_buffer_ok(frame, sizeof(sig_frame_t))){
+        return FAIL_NEG_ONE;
+    }
+    saved = &frame->context;
+    regs->ebx = saved->ebx;
+    regs->ecx = saved->ecx;
+    regs->edx = saved->edx;
+    regs->esi = saved->esi;
+    regs->edi = saved->edi;
+    regs->ebp = saved->ebp;
+    regs->eip = saved->eip;
+    regs->esp = saved->esp;
+    regs->eflags = (saved->eflags & EFLAGS_USER_MASK) | EFLAGS_IF;
+    current_pcb()->sig_blocked = frame->blocked & SIG_ALL;
+    return saved->eax;
+}
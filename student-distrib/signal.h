@@ -0,0 +1,66 @@
+/* signal.h: signals delivered to user programs on their way back to user mode */
+
+#ifndef _SIGNAL_H
+#define _SIGNAL_H
+
+#include "types.h"
+
+/* signal numbers, the same as enum signums in syscalls/ece391syscall.h */
+#define SIG_DIV_ZERO    0
+#define SIG_SEGFAULT    1
+#define SIG_INTERRUPT   2
+#define SIG_ALARM       3
+#define SIG_USER1       4
+#define NUM_SIGNALS     5
+#define SIG_ALL         ((1 << NUM_SIGNALS) - 1)
+#define SIG_DEFAULT_KILL ((1 << SIG_DIV_ZERO) | (1 << SIG_SEGFAULT) | (1 << SIG_INTERRUPT))  // others are ignored
+
+#define ALARM_PERIOD_SEC    10          // SIG_ALARM to the foreground program of the visible terminal
+#define EFLAGS_IF           0x200
+#define EFLAGS_USER_MASK    0xDD5       // CF PF AF ZF SF TF DF OF, what sigreturn takes from the user
+
+/* Registers saved by every interrupt, exception and system call linkage in intr_linkage.S,
+ * lowest address first. esp and ss are only there when the CPU came from user mode. */
+typedef struct hw_context_t {
+    uint32_t ebx;
+    uint32_t ecx;
+    uint32_t edx;
+    uint32_t esi;
+    uint32_t edi;
+    uint32_t ebp;
+    uint32_t eax;
+    uint32_t ds;
+    uint32_t es;
+    uint32_t fs;
+    uint32_t irq_exc;                   // vector number
+    uint32_t error_code;                // 0 when the CPU pushes none
+    uint32_t eip;
+    uint32_t cs;
+    uint32_t eflags;
+    uint32_t esp;
+    uint32_t ss;
+} hw_context_t;
+
+/* Frame pushed on the user stack for a handler. The handler returns into the trampoline,
+ * which calls sigreturn with esp just above ret_addr. */
+typedef struct sig_frame_t {
+    uint32_t ret_addr;                  // points at trampoline
+    uint32_t signum;                    // argument of the handler
+    hw_context_t context;               // registers of the interrupted program
+    uint32_t blocked;                   // mask to restore in sigreturn
+    uint8_t trampoline[8];              // movl $SIGRETURN_NUM, %eax; int $0x80
+} sig_frame_t;
+
+struct pcb_struct;
+
+void send_signal(struct pcb_struct* pcb, int32_t signum);
+int32_t signal_pending(struct pcb_struct* pcb);
+int32_t signal_from_exception(int32_t intr_num, hw_context_t* regs);
+int32_t do_signal(hw_context_t* regs);
+void signal_alarm_tick(void);
+
+/* system calls */
+int32_t set_handler(int32_t signum, void* handler_address);
+int32_t sigreturn(void);
+
+#endif /* _SIGNAL_H */
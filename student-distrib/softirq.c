@@ -0,0 +1,160 @@
+/* softirq.c - deferred work (bottom halves) for the interrupt handlers
+ * Top halves acknowledge the device, raise their source and return. do_softirq
+ * runs the raised sources after the EOI with interrupts enabled, in source order,
+ * followed by the tasklets queued on each source.
+ */
+
+#include "softirq.h"
+#include "lib.h"
+
+typedef struct softirq_source_t {
+    softirq_handler_t handler;
+    tasklet_t* head;                // tasklet queue, FIFO
+    tasklet_t* tail;
+} softirq_source_t;
+
+static softirq_source_t sources[NUM_SOFTIRQS];
+static volatile uint32_t softirq_pending = 0;
+static volatile uint32_t softirq_active = 0;
+softirq_stat_t softirq_stats[NUM_SOFTIRQS];
+
+/* void softirq_init(void)
+ * Inputs: none
+ * Return Value: none
+ * Function: clears all handlers, queues and statistics */
+void softirq_init(void){
+    uint32_t nr;
+    for(nr = 0; nr < NUM_SOFTIRQS; nr++){
+        sources[nr].handler = NULL;
+        sources[nr].head = NULL;
+        sources[nr].tail = NULL;
+    }
+    memset(softirq_stats, 0, sizeof(softirq_stats));
+    softirq_pending = 0;
+    softirq_active = 0;
+}
+
+/* void open_softirq(uint32_t nr, softirq_handler_t handler)
+ * Inputs: uint32_t nr -- softirq source
+ *         softirq_handler_t handler -- bottom half to run when the source is raised
+ * Return Value: none
+ * Function: registers the bottom half of a source */
+void open_softirq(uint32_t nr, softirq_handler_t handler){
+    if(nr >= NUM_SOFTIRQS) return;
+    sources[nr].handler = handler;
+}
+
+/* void raise_softirq(uint32_t nr)
+ * Inputs: uint32_t nr -- softirq source
+ * Return Value: none
+ * Function: marks a source pending, safe to call from a top half */
+void raise_softirq(uint32_t nr){
+    uint32_t flags;
+    if(nr >= NUM_SOFTIRQS) return;
+    cli_and_save(flags);
+    softirq_pending |= (1 << nr);
+    softirq_stats[nr].raised++;
+    restore_flags(flags);
+}
+
+/* void tasklet_schedule(uint32_t nr, tasklet_t* t)
+ * Inputs: uint32_t nr -- softirq source whose queue the tasklet joins
+ *         tasklet_t* t -- tasklet, func and data filled in by the caller
+ * Return Value: none
+ * Function: queues a tasklet and raises its source, does nothing if it is already queued */
+void tasklet_schedule(uint32_t nr, tasklet_t* t){
+    uint32_t flags;
+    if(nr >= NUM_SOFTIRQS || t == NULL) return;
+    cli_and_save(flags);
+    if(!t->scheduled){
+        t->scheduled = 1;
+        t->next = NULL;
+        if(sources[nr].tail == NULL){
+            sources[nr].head = t;
+        }else{
+            sources[nr].tail->next = t;
+        }
+        sources[nr].tail = t;
+    }
+    softirq_pending |= (1 << nr);
+    softirq_stats[nr].raised++;
+    restore_flags(flags);
+}
+
+/* void run_source(uint32_t nr)
+ * Inputs: uint32_t nr -- softirq source
+ * Return Value: none
+ * Function: runs the handler and the queued tasklets of one source with interrupts enabled,
+ *           called and returns with interrupts disabled */
+static void run_source(uint32_t nr){
+    tasklet_t* list;
+    tasklet_t* next;
+    uint64_t start, elapsed;
+
+    list = sources[nr].head;        // take the whole queue, new tasklets go to the next round
+    sources[nr].head = NULL;
+    sources[nr].tail = NULL;
+
+    start = rdtsc();
+    sti();
+    if(sources[nr].handler != NULL){
+        sources[nr].handler();
+    }
+    while(list != NULL){
+        next = list->next;
+        cli();
+        list->scheduled = 0;        // may be queued again from here on
+        sti();
+        list->func(list->data);
+        softirq_stats[nr].tasklets++;
+        list = next;
+    }
+    cli();
+    elapsed = rdtsc() - start;
+    softirq_stats[nr].runs++;
+    softirq_stats[nr].cycles += elapsed;
+    if((elapsed >> 32) != 0 || (uint32_t)elapsed > softirq_stats[nr].max_cycles){
+        softirq_stats[nr].max_cycles = ((elapsed >> 32) != 0) ? 0xFFFFFFFF : (uint32_t)elapsed;
+    }
+}
+
+/* uint32_t softirq_running(void)
+ * Inputs: none
+ * Return Value: 1 while do_softirq runs, 0 otherwise
+ * Function: lets the PIT handler hold back a task switch until the softirqs are done, a
+ *           switch in between would leave them half run in the task switched away from */
+uint32_t softirq_running(void){
+    return softirq_active;
+}
+
+/* void do_softirq(void)
+ * Inputs: none
+ * Return Value: none
+ * Function: runs all pending sources. Called by hardware_handler after the EOI. A call that
+ *           interrupts a running do_softirq returns at once, the running one sees the new
+ *           pending bits. A PIT tick meanwhile does not switch tasks, see pit_handler, so
+ *           the whole run happens in one task. Returns with interrupts disabled. */
+void do_softirq(void){
+    uint32_t pending, nr, restart;
+
+    cli();
+    if(softirq_active){
+        return;
+    }
+    softirq_active = 1;
+
+    for(restart = 0; restart < SOFTIRQ_MAX_RESTART; restart++){
+        pending = softirq_pending;
+        if(pending == 0){
+            break;
+        }
+        softirq_pending = 0;
+        for(nr = 0; nr < NUM_SOFTIRQS; nr++){
+            if(pending & (1 << nr)){
+                run_source(nr);
+            }
+        }
+    }
+
+    softirq_active = 0;
+}
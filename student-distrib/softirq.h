@@ -0,0 +1,45 @@
+/* softirq.h - deferred work (bottom halves) run after the hardware EOI with interrupts enabled */
+
+#ifndef _SOFTIRQ_H
+#define _SOFTIRQ_H
+
+#include "types.h"
+
+/* softirq sources, lower numbers run first */
+#define SOFTIRQ_TIMER       0
+#define SOFTIRQ_KEYBOARD    1
+#define SOFTIRQ_RTC         2
+#define SOFTIRQ_SERIAL      3
+#define NUM_SOFTIRQS        4
+
+#define SOFTIRQ_MAX_RESTART 10  // rounds do_softirq runs before leaving the rest for the next interrupt
+
+typedef void (*softirq_handler_t)(void);
+
+/* A tasklet is a one-shot function queued on a source, run after that source's handler */
+typedef struct tasklet_t {
+    void (*func)(uint32_t data);
+    uint32_t data;
+    uint32_t scheduled;             // 1 while queued, a queued tasklet is not queued again
+    struct tasklet_t* next;
+} tasklet_t;
+
+/* Per-source runtime accounting */
+typedef struct softirq_stat_t {
+    uint32_t raised;                // raise_softirq calls
+    uint32_t runs;                  // handler invocations
+    uint32_t tasklets;              // tasklets run
+    uint64_t cycles;                // TSC cycles spent in the handler and its tasklets
+    uint32_t max_cycles;            // longest single run
+} softirq_stat_t;
+
+void softirq_init(void);
+void open_softirq(uint32_t nr, softirq_handler_t handler);
+void raise_softirq(uint32_t nr);
+void tasklet_schedule(uint32_t nr, tasklet_t* t);
+void do_softirq(void);
+uint32_t softirq_running(void);
+
+extern softirq_stat_t softirq_stats[NUM_SOFTIRQS];
+
+#endif /* _SOFTIRQ_H */
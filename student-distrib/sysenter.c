@@ -0,0 +1,71 @@
+/* sysenter.c: SYSENTER/SYSEXIT fast system call entry
+ * SYSENTER skips the IDT lookup and the privilege checks of int 0x80. The CPU takes CS, esp
+ * and eip from the IA32_SYSENTER MSRs, and sysenter_entry moves to the process' kernel stack
+ * and dispatches through the same syscall_jump_table. int 0x80 keeps working unchanged, user
+ * programs pick the path when they are linked (see syscalls/Makefile).
+ */
+
+#include "sysenter.h"
+#include "x86_desc.h"
+#include "lib.h"
+#include "klog.h"
+#include "vdso.h"
+
+uint32_t sysenter_enabled = 0;
+
+static uint8_t sysenter_stack[SYSENTER_STACK_SIZE] __attribute__((aligned (16)));
+
+/* static void wrmsr(uint32_t msr, uint32_t val);
+ * Inputs: uint32_t msr -- model specific register number
+ *         uint32_t val -- low 32 bits to write, the high half is 0
+ * Return Value: none
+ *  Function: writes a model specific register */
+static void wrmsr(uint32_t msr, uint32_t val){
+    asm volatile ("wrmsr"
+                    :
+                    : "c"(msr), "a"(val), "d"(0)
+                    );
+}
+
+/* static int32_t sysenter_supported(void);
+ * Inputs: none
+ * Return Value: 1 if the CPU has working SYSENTER/SYSEXIT, 0 if not
+ *  Function: checks the SEP bit of CPUID leaf 1. The original Pentium Pro (family 6, model
+ *            below 3, stepping below 3) sets the bit without supporting the instructions */
+static int32_t sysenter_supported(void){
+    uint32_t eax, ebx, ecx, edx;
+    uint32_t family, model, stepping;
+
+    asm volatile ("cpuid"
+                    : "=a"(eax), "=b"(ebx), "=c"(ecx), "=d"(edx)
+                    : "a"(CPUID_FEATURES)
+                    );
+    if(!(edx & CPUID_EDX_SEP)){
+        return 0;
+    }
+    family = (eax >> 8) & 0xF;
+    model = (eax >> 4) & 0xF;
+    stepping = eax & 0xF;
+    if(family == 6 && model < 3 && stepping < 3){
+        return 0;
+    }
+    return 1;
+}
+
+/* void sysenter_init(void);
+ * Inputs: none
+ * Return Value: none
+ *  Function: programs the SYSENTER MSRs and advertises the fast path in the vdso page.
+ *            Call after vdso_init */
+void sysenter_init(void){
+    if(!sysenter_supported()){
+        klog(KLOG_INFO, "sysenter: not supported, int 0x80 only");
+        return;
+    }
+    wrmsr(MSR_SYSENTER_CS, KERNEL_CS);   // SYSEXIT derives USER_CS/USER_DS from it
+    wrmsr(MSR_SYSENTER_ESP, (uint32_t)(sysenter_stack + SYSENTER_STACK_SIZE));
+    wrmsr(MSR_SYSENTER_EIP, (uint32_t)sysenter_entry);
+    sysenter_enabled = 1;
+    vdso_data->features |= VDSO_FEAT_SYSENTER;
+    klog(KLOG_INFO, "sysenter: enabled");
+}
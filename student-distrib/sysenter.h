@@ -0,0 +1,23 @@
+/* sysenter.h: SYSENTER/SYSEXIT fast system call entry */
+
+#ifndef _SYSENTER_H
+#define _SYSENTER_H
+
+#include "types.h"
+
+#define MSR_SYSENTER_CS     0x174
+#define MSR_SYSENTER_ESP    0x175
+#define MSR_SYSENTER_EIP    0x176
+
+#define CPUID_FEATURES      1
+#define CPUID_EDX_SEP       (1 << 11)   // SYSENTER/SYSEXIT present
+#define SYSENTER_STACK_SIZE 64          // only used until sysenter_entry loads tss.esp0
+
+extern uint32_t sysenter_enabled;
+
+/* assembly entry point in intr_linkage.S */
+extern void sysenter_entry(void);
+
+void sysenter_init(void);
+
+#endif /* _SYSENTER_H */
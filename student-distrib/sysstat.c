@@ -0,0 +1,196 @@
+/* sysstat.c - system call counters and latency histograms
+ * The system call linkage calls sysstat_enter before and sysstat_exit after every valid
+ * system call. They count the call for the whole system and for the calling process (a
+ * thread counts toward its program), and time it with the TSC into a log2 histogram per
+ * call. execute is timed until the program it ran halts. The tables are read as text from
+ * the virtual file "syscalls":
+ *     <call> <calls> <average cycles> <log2 bucket>:<returns> ...
+ * for every call used since boot or the last clear, then one line per live task:
+ *     <pid> <name> <call>=<calls>/<average cycles> ...
+ * Writing anything to the file clears the system wide table.
+ */
+
+#include "sysstat.h"
+#include "lib.h"
+#include "clock.h"
+#include "system_call.h"
+#include "thread.h"
+#include "timer.h"
+
+/* names in the order of syscall_jump_table in intr_linkage.S */
+static const int8_t* sysstat_names[NUM_SYS_CALLS] = {
+    "none", "halt", "execute", "read", "write", "open", "close", "getargs", "vidmap",
+    "set_handler", "sigreturn", "ioctl", "clock_gettime", "nanosleep", "uring_setup",
+    "uring_enter", "pipe", "dup2", "spawn", "shm_get", "shm_attach", "shm_detach",
+    "futex_wait", "futex_wake", "poll", "waitpid", "thread_create", "thread_join",
+    "thread_exit", "profile"
+};
+
+static sysstat_t sysstat[NUM_SYS_CALLS];
+
+/* fails to compile if the PCB counters and the jump table disagree in size */
+typedef int8_t pcb_sys_calls_check[(PCB_SYS_CALLS == NUM_SYS_CALLS) ? 1 : -1];
+
+fop_table_t sysstat_fop = {
+    sysstat_open,
+    sysstat_close,
+    sysstat_read,
+    sysstat_write
+};
+
+/* uint32_t log2_u64(uint64_t v)
+ * Inputs: uint64_t v -- value
+ * Return Value: index of the highest set bit, 0 for 0
+ * Function: bucket of a latency */
+static uint32_t log2_u64(uint64_t v){
+    uint32_t hi = (uint32_t)(v >> 32);
+    uint32_t lo = (uint32_t)v;
+    uint32_t bit;
+
+    if(hi != 0){
+        asm ("bsrl %1, %0" : "=r"(bit) : "rm"(hi));
+        return bit + 32;
+    }
+    if(lo != 0){
+        asm ("bsrl %1, %0" : "=r"(bit) : "rm"(lo));
+        return bit;
+    }
+    return 0;
+}
+
+/* uint32_t avg_cycles(uint64_t total, uint32_t n)
+ * Inputs: uint64_t total -- cycles
+ *         uint32_t n -- calls
+ * Return Value: total / n, 0 if n is 0 and 0xFFFFFFFF if it does not fit in 32 bits */
+uint32_t avg_cycles(uint64_t total, uint32_t n){
+    if(n == 0) return 0;
+    if((uint32_t)(total >> 32) >= n) return 0xFFFFFFFF;     // divl would fault
+    return div_u64(total, n, NULL);
+}
+
+/* uint64_t sysstat_enter(uint32_t nr)
+ * Inputs: uint32_t nr -- system call number, 1 to NUM_SYS_CALLS-1
+ * Return Value: TSC at entry, handed back to sysstat_exit
+ * Function: counts the call */
+uint64_t sysstat_enter(uint32_t nr){
+    uint32_t flags;
+
+    cli_and_save(flags);        // interrupts are on in system calls
+    sysstat[nr].calls++;
+    group_leader(current_pcb())->sys_calls[nr]++;
+    restore_flags(flags);
+    return rdtsc();
+}
+
+/* void sysstat_exit(uint64_t start, uint32_t nr)
+ * Inputs: uint64_t start -- TSC at entry
+ *         uint32_t nr -- system call number
+ * Return Value: none
+ * Function: records the latency of a call that returned, charged to the process it returns
+ *           to */
+void sysstat_exit(uint64_t start, uint32_t nr){
+    uint64_t cycles = rdtsc() - start;
+    uint32_t bucket = log2_u64(cycles);
+    uint32_t flags;
+
+    if(bucket >= SYSSTAT_BUCKETS) bucket = SYSSTAT_BUCKETS - 1;
+    cli_and_save(flags);
+    sysstat[nr].returns++;
+    sysstat[nr].cycles += cycles;
+    sysstat[nr].hist[bucket]++;
+    group_leader(current_pcb())->sys_cycles[nr] += cycles;
+    restore_flags(flags);
+}
+
+/* uint32_t sysstat_total(void)
+ * Inputs: none
+ * Return Value: system calls made since boot or the last clear
+ * Function: sums the table for procfs.c */
+uint32_t sysstat_total(void){
+    uint32_t nr, total = 0;
+
+    for(nr = 1; nr < NUM_SYS_CALLS; nr++){
+        total += sysstat[nr].calls;
+    }
+    return total;
+}
+
+/* void sysstat_clear(pcb_struct* pcb)
+ * Inputs: pcb_struct* pcb -- new process
+ * Return Value: none
+ * Function: zeroes the counters of a process, done when it starts */
+void sysstat_clear(pcb_struct* pcb){
+    memset(pcb->sys_calls, 0, sizeof(pcb->sys_calls));
+    memset(pcb->sys_cycles, 0, sizeof(pcb->sys_cycles));
+}
+
+/* int32_t sysstat_open(const uint8_t* filename)
+ * Inputs: const uint8_t* filename -- "syscalls"
+ * Return Value: file descriptor, -1 if none is free
+ * Function: opens the tables */
+int32_t sysstat_open(const uint8_t* filename){
+    return alloc_fd(&sysstat_fop, 0, 0);
+}
+
+/* int32_t sysstat_close(int32_t fd)
+ * Inputs: int32_t fd -- file descriptor
+ * Return Value: 0
+ * Function: releases the descriptor */
+int32_t sysstat_close(int32_t fd){
+    files_pcb()->file_descriptor[fd].flags = 0;
+    return 0;
+}
+
+/* int32_t sysstat_read(int32_t fd, void* buf, int32_t nbytes)
+ * Inputs: int32_t fd -- file descriptor
+ *         void* buf -- user buffer
+ *         int32_t nbytes -- its size
+ * Return Value: bytes read, 0 at the end
+ * Function: formats the tables described at the top of the file. The counters keep moving
+ *           between reads, a small buffer can see lines from different moments. */
+int32_t sysstat_read(int32_t fd, void* buf, int32_t nbytes){
+    vfile_t vf;
+    pcb_struct* pcb;
+    sysstat_t* s;
+    uint32_t nr, b;
+    int32_t pid;
+
+    vfile_begin(&vf, fd, buf, nbytes);
+    for(nr = 1; nr < NUM_SYS_CALLS; nr++){
+        s = &sysstat[nr];
+        if(s->calls == 0) continue;
+        vfile_printf(&vf, "%-14s %8u %10u", sysstat_names[nr], s->calls,
+                     avg_cycles(s->cycles, s->returns));
+        for(b = 0; b < SYSSTAT_BUCKETS; b++){
+            if(s->hist[b] != 0) vfile_printf(&vf, " %u:%u", b, s->hist[b]);
+        }
+        vfile_printf(&vf, "\n");
+    }
+    for(pid = 0; pid < MAX_TASKS; pid++){
+        pcb = task_pcb(pid);
+        if(pcb == NULL || pcb->group_leader != NULL) continue;   // threads count in the leader
+        vfile_printf(&vf, "%u %s", pid, pcb->name);
+        for(nr = 1; nr < NUM_SYS_CALLS; nr++){
+            if(pcb->sys_calls[nr] == 0) continue;
+            vfile_printf(&vf, " %s=%u/%u", sysstat_names[nr], pcb->sys_calls[nr],
+                         avg_cycles(pcb->sys_cycles[nr], pcb->sys_calls[nr]));
+        }
+        vfile_printf(&vf, "\n");
+    }
+    return vfile_end(&vf, fd);
+}
+
+/* int32_t sysstat_write(int32_t fd, const void* buf, int32_t nbytes)
+ * Inputs: int32_t fd -- file descriptor
+ *         const void* buf -- ignored
+ *         int32_t nbytes -- its size
+ * Return Value: nbytes
+ * Function: clears the system wide table, before a workload to measure */
+int32_t sysstat_write(int32_t fd, const void* buf, int32_t nbytes){
+    uint32_t flags;
+
+    cli_and_save(flags);
+    memset(sysstat, 0, sizeof(sysstat));
+    restore_flags(flags);
+    return nbytes;
+}
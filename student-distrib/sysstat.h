@@ -0,0 +1,33 @@
+/* sysstat.h - system call counters and latency histograms */
+
+#ifndef _SYSSTAT_H
+#define _SYSSTAT_H
+
+#include "types.h"
+#include "filesys.h"
+#include "idt_number.h"
+
+#define SYSSTAT_BUCKETS 40      // log2 latency buckets in cycles, the last takes anything longer
+
+typedef struct sysstat_t {
+    uint32_t calls;                     // entries, halt and thread_exit never return
+    uint32_t returns;
+    uint64_t cycles;                    // total latency of the returns
+    uint32_t hist[SYSSTAT_BUCKETS];     // returns taking 2^i to 2^(i+1) - 1 cycles
+} sysstat_t;
+
+/* called by SYSSTAT_CALL in intr_linkage.S */
+uint64_t sysstat_enter(uint32_t nr);
+void sysstat_exit(uint64_t start, uint32_t nr);
+
+void sysstat_clear(pcb_struct* pcb);
+uint32_t sysstat_total(void);
+uint32_t avg_cycles(uint64_t total, uint32_t n);
+
+/* virtual file "syscalls" */
+int32_t sysstat_open(const uint8_t* filename);
+int32_t sysstat_close(int32_t fd);
+int32_t sysstat_read(int32_t fd, void* buf, int32_t nbytes);
+int32_t sysstat_write(int32_t fd, const void* buf, int32_t nbytes);
+
+#endif /* _SYSSTAT_H */
@@ -8,6 +8,15 @@
 #include "terminal.h"
 #include "scheduling.h"
 #include "i8259.h"
+#include "klog.h"
+#include "vdso.h"
+#include "timer.h"
+#include "pipe.h"
+#include "shm.h"
+#include "thread.h"
+#include "fpu.h"
+#include "sysstat.h"
+#include "procfs.h"
 
 #define FIRST_TERMINAL_BUF (0xB8000 + 4096) 
 #define SECOND_TERMINAL_BUF (0xB8000 + 4096 * 2) 
@@ -24,19 +33,22 @@ fop_table_t stdin_fop = {
     terminal_open, 
     terminal_close,
     terminal_read, 
-    invalid_terminal_write 
+    invalid_terminal_write,
+    terminal_poll
 };
 fop_table_t stdout_fop = {
     terminal_open,
     terminal_close,
     invalid_terminal_read,
-    terminal_write
+    terminal_write,
+    terminal_write_poll
 };
 fop_table_t rtc_fop = {
     rtc_open,
     rtc_close,
     rtc_read,
-    rtc_write
+    rtc_write,
+    rtc_poll
 };
 fop_table_t directory_fop = {
     directory_open,
@@ -51,6 +63,15 @@ fop_table_t file_fop = {
     file_write
 };
 
+/* virtual files that are not in the file system image, open() looks here when
+ * read_dentry_by_name fails */
+device_file_t device_files[] = {
+    {"klog", &klog_fop},
+    {"profile", &prof_fop},
+    {"syscalls", &sysstat_fop},
+    {NULL, NULL}
+};
+
 
 /* int32_t exception_halt(uint16_t status);
  * Inputs: uint8_t status
@@ -63,15 +84,22 @@ fop_table_t file_fop = {
 int32_t exception_halt (uint16_t status){
     cli();
     int i;
+    if(current_pcb()->group_leader != NULL){    // a thread ends alone, see thread_exit
+        thread_exit(status);
+    }
     process_count--;
     saved_status_num = status;
     pcb_struct* current_pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1)); // get ptr to parent pcbb
+    thread_group_kill(current_pcb);     // its threads run in the page and files about to go
+    if(current_pcb->spawned){   // no parent waits in execute for a spawned process
+        halt_spawned(current_pcb, saved_status_num);
+    }
 
     // Restore the TSS and paging
     if(current_pcb->is_base_shell == 0 ){     //check for shell
         tss.esp0 = EIGHT_MB - EIGHT_KB*(current_pcb->parent_id) - FOUR_BYTES; // restore parent's kernel-mode stack
         tss.ss0 = KERNEL_DS; //pointer to kernel’s stack segment
-        paging_execute(current_pcb->parent_id);       // restore parent program file
+        paging_execute(group_leader((pcb_struct*)(EIGHT_MB - EIGHT_KB*(current_pcb->parent_id+1)))->pid);  // restore parent program file
         disable_child_page();   // disable child program page
     }else{
         shell_halt_flag = 1;
@@ -81,16 +109,23 @@ int32_t exception_halt (uint16_t status){
     file_descriptor* curr_fd = current_pcb->file_descriptor;   // get ptr to current fd
 
     // close open fds
-    for(i = 0; i < FD_MAX; i++) {
+    for(i = 0; i <= FD_MAX; i++) {
         if(curr_fd[i].flags == 1) curr_fd[i].file_operations_table_pointer->close(i);
     }
+    shm_detach_all(current_pcb);
+    release_children(current_pcb);
     
     if(current_pcb->is_base_shell == 0  ){     //If not base shell case
         pcb_struct* parent_pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(current_pcb->parent_id+1));     // get parent process pcb
-        schedule_array[current_pcb->terminal_num] = parent_pcb->pid;                                // update queue       
-        terminal[current_pcb->terminal_num].curr_pid = current_pcb->parent_id;        
+        shm_switch(group_leader(parent_pcb));                                                       // parent's segments back
+        schedule_array[current_pcb->slot] = parent_pcb->pid;                                        // update queue       
+        if(current_pcb->slot == current_pcb->terminal_num){                                         // in front of the terminal
+            terminal[current_pcb->terminal_num].curr_pid = current_pcb->parent_id;        
+        }
         current_pcb->active = 0;
         parent_pcb->active = 1; 
+        fpu_release(current_pcb);
+        fpu_switch(parent_pcb);
         process_num = current_pcb->parent_id;  
 
         if(current_pcb->is_shell == 1){
@@ -136,15 +171,22 @@ int32_t exception_halt (uint16_t status){
 int32_t system_halt (uint8_t status){
     cli();
     int i;
+    if(current_pcb()->group_leader != NULL){    // a thread ends alone, see thread_exit
+        thread_exit(status);
+    }
     process_count--;
     saved_status_num = status;
     pcb_struct* current_pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1)); // get ptr to parent pcbb
+    thread_group_kill(current_pcb);     // its threads run in the page and files about to go
+    if(current_pcb->spawned){   // no parent waits in execute for a spawned process
+        halt_spawned(current_pcb, saved_status_num);
+    }
 
     // Restore the TSS and paging
     if(current_pcb->is_base_shell == 0 ){     //check for shell
         tss.esp0 = EIGHT_MB - EIGHT_KB*(current_pcb->parent_id) - FOUR_BYTES; // restore parent's kernel-mode stack
         tss.ss0 = KERNEL_DS; //pointer to kernel’s stack segment
-        paging_execute(current_pcb->parent_id);       // restore parent program file
+        paging_execute(group_leader((pcb_struct*)(EIGHT_MB - EIGHT_KB*(current_pcb->parent_id+1)))->pid);  // restore parent program file
         disable_child_page();   // disable child program page
     }else{
         shell_halt_flag = 1;
@@ -154,16 +196,23 @@ int32_t system_halt (uint8_t status){
     file_descriptor* curr_fd = current_pcb->file_descriptor;   // get ptr to current fd
 
     // close open fds
-    for(i = 0; i < FD_MAX; i++) {
+    for(i = 0; i <= FD_MAX; i++) {
         if(curr_fd[i].flags == 1) curr_fd[i].file_operations_table_pointer->close(i);
     }
+    shm_detach_all(current_pcb);
+    release_children(current_pcb);
     
     if(current_pcb->is_base_shell == 0  ){     //If not base shell case
         pcb_struct* parent_pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(current_pcb->parent_id+1));     // get parent process pcb
-        schedule_array[current_pcb->terminal_num] = parent_pcb->pid;                                // update queue       
-        terminal[current_pcb->terminal_num].curr_pid = current_pcb->parent_id;        
+        shm_switch(group_leader(parent_pcb));                                                       // parent's segments back
+        schedule_array[current_pcb->slot] = parent_pcb->pid;                                        // update queue       
+        if(current_pcb->slot == current_pcb->terminal_num){                                         // in front of the terminal
+            terminal[current_pcb->terminal_num].curr_pid = current_pcb->parent_id;        
+        }
         current_pcb->active = 0;
         parent_pcb->active = 1; 
+        fpu_release(current_pcb);
+        fpu_switch(parent_pcb);
         process_num = current_pcb->parent_id;  
 
         if(current_pcb->is_shell == 1){
@@ -221,7 +270,7 @@ int32_t execute (const uint8_t* command){
     // Check if we are on the 6th shell and limit to that
     if(!strncmp((const int8_t*)file_name, "shell", FIVE_BYTES)){
         if(shell_process_count >= SHELL_LIMIT){
-            printf("Already at 6th Shell! Can't open more \n");
+            klog(KLOG_WARN, "Already at 6th Shell! Can't open more");
             asm volatile ("jmp return_to_exe;"
                             :                /* output */
                             :  /* input */
@@ -322,6 +371,35 @@ int32_t execute (const uint8_t* command){
     // setup the PCB for the general case
     pcb->pid = local_process_num; // zero-indexed
     pcb->active = 1; // activated process, useful for later checkpoints
+    pcb->state = PROC_RUNNABLE;
+    pcb->on_timer_queue = 0;
+    pcb->timer_next = NULL;
+    pcb->uring = NULL;
+    pcb->wait_next = NULL;
+    pcb->wait_queue = NULL;
+    pcb->spawned = 0;
+    pcb->fresh = 0;
+    strncpy((int8_t*)pcb->args, (const int8_t*)stored_buf, ARGS_LEN - 1);
+    pcb->args[ARGS_LEN - 1] = '\0';
+    strncpy((int8_t*)pcb->name, (const int8_t*)curr_dentry.filename, DENTRY_FILE_NAME_LEN);
+    pcb->name[DENTRY_FILE_NAME_LEN] = '\0';
+    sysstat_clear(pcb);
+    pcb->sched_ticks = 0;
+    pcb->sched_switches = 0;
+    pcb->shm_attached = 0;
+    pcb->shm_held = 0;
+    shm_switch(pcb);
+    pcb->futex_addr = 0;
+    pcb->sig_pending = 0;
+    pcb->sig_blocked = 0;
+    memset(pcb->sig_handler, 0, sizeof(pcb->sig_handler));
+    pcb->zombie = 0;
+    pcb->in_waitpid = 0;
+    pcb->first_child = NULL;
+    pcb->kthread = 0;
+    pcb->group_leader = NULL;
+    pcb->next_thread = NULL;
+    fpu_release(pcb);
     asm volatile ("movl %%esp, %0;" 
                     :"=r"(pcb->saved_parents_esp)  /* output */
                     :                /* input */
@@ -332,10 +410,6 @@ int32_t execute (const uint8_t* command){
                     :                 /* input */
                     :"%eax"           /* clobbered register */
                     );      
-    pcb->file_descriptor[0].file_operations_table_pointer = &stdin_fop; //manually open stdin
-    pcb->file_descriptor[0].flags = 1;
-    pcb->file_descriptor[1].file_operations_table_pointer = &stdout_fop; //manually open stdout
-    pcb->file_descriptor[1].flags = 1;
     if(is_shell_flag == 1){
         pcb->is_shell = 1;
     }else{
@@ -347,18 +421,29 @@ int32_t execute (const uint8_t* command){
         pcb->terminal_num = pit_count;
         pcb->is_base_shell = 1;
         pcb->parent_id = -1;
-        schedule_array[pcb->terminal_num] = pit_count;
+        pcb->slot = pit_count;
+        schedule_array[pcb->slot] = pit_count;
         terminal[pit_count].curr_pid = schedule_array[pit_count];
         pit_count++;
     }else{
         if(pcb->is_base_shell != 1){
             pcb_struct* parent_pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pcb->parent_id+1));     // get parent process pcb
             pcb->terminal_num = parent_pcb->terminal_num;                                       // set new process terminal_num
+            pcb->slot = parent_pcb->slot;                                                       // take over the parent's slot
         }else{
             pcb->terminal_num = pcb->terminal_num;
         }
-        schedule_array[pcb->terminal_num] = local_process_num;                              // update queue               
-        terminal[pcb->terminal_num].curr_pid = schedule_array[pcb->terminal_num];
+        schedule_array[pcb->slot] = local_process_num;                                      // update queue               
+        if(pcb->slot == pcb->terminal_num){                                                 // in front of the terminal
+            terminal[pcb->terminal_num].curr_pid = schedule_array[pcb->slot];
+        }
+    }
+
+    // stdin and stdout: the terminal for a base shell, otherwise inherited so they may be pipes
+    if(pcb->is_base_shell == 1){
+        setup_std_fds(pcb, NULL);
+    }else{
+        setup_std_fds(pcb, (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pcb->parent_id+1)));
     }
 
     // Context Switch and IRET
@@ -367,6 +452,7 @@ int32_t execute (const uint8_t* command){
 
     // increment process_num
     process_num = local_process_num;
+    fpu_switch(pcb);
     context_switch(pcb->entry_point); //entry point from bytes 24-27
 
     asm volatile ("return_to_exe: \n\
@@ -510,12 +596,12 @@ void paging_execute(int32_t local_process_num){
 int32_t read (int32_t fd, void* buf, int32_t n){
     cli();
     disable_irq(0); // Disable PIT to avoid interrupt
-    if(fd != 0){
-        enable_irq(0);
+    if(fd != 0 || files_pcb()->file_descriptor[0].file_operations_table_pointer != &stdin_fop){
+        enable_irq(0);  // only the keyboard wants it off, a pipe reader sleeps until the writer runs
     }   
     cli();
     
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[schedule_idx].curr_pid +1));   
+    pcb_struct* pcb = files_pcb();   
     // pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));  // Create PCB
     int32_t bytes_read;
     if(fd < FD_STDIN || fd > FD_MAX || buf == NULL || n < 0 || pcb->file_descriptor[fd].flags == 0){  //Check for bad input
@@ -533,7 +619,7 @@ int32_t read (int32_t fd, void* buf, int32_t n){
     }
     else {
         sti();
-        return n;
+        return bytes_read;
     }
 }
 
@@ -548,7 +634,7 @@ int32_t read (int32_t fd, void* buf, int32_t n){
 int32_t write (int32_t fd, const void* buf, int32_t n){
     cli();
     
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[schedule_idx].curr_pid +1));   
+    pcb_struct* pcb = files_pcb();   
     // pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1));  // Create PCB
 
     if(fd < FD_STDIN || fd > FD_MAX || buf == NULL || n < 0 || pcb->file_descriptor[fd].flags == 0){ //Check for bad input
@@ -583,9 +669,10 @@ int32_t open (const uint8_t* filename){
         sti();
         return FAIL_NEG_ONE;
     }
-    if(read_dentry_by_name(filename, &dentry) == -1){ // If the named file does not exist
+    if(read_dentry_by_name(filename, &dentry) == -1 && procfs_dentry_by_name(filename, &dentry) == -1){
+        open_success = device_open(filename);         // not a file, it may still be a virtual one
         sti();
-        return FAIL_NEG_ONE; 
+        return open_success; 
     }
 
     if(dentry.file_type == RTC){       //open the right file by setting up the appropriate fop table
@@ -597,6 +684,9 @@ int32_t open (const uint8_t* filename){
     else if(dentry.file_type == FILE){
        open_success = file_open(filename);//regular
     }
+    else if(dentry.file_type == PROC_FILE){
+       open_success = procfs_open(filename);//generated by procfs.c
+    }
     sti();
     return open_success;
 }
@@ -610,13 +700,14 @@ int32_t open (const uint8_t* filename){
 int32_t close (int32_t fd){
     cli();
     // pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(process_num+1)); //Create PCB
-    pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[schedule_idx].curr_pid +1));   
+    pcb_struct* pcb = files_pcb();   
     
     if(pcb->file_descriptor[fd].flags == 0 || fd < FD_MIN || fd > FD_MAX){        // Check for bad input
         sti();
         return FAIL_NEG_ONE;
     }
     pcb->file_descriptor[fd].file_operations_table_pointer->close(fd);  //make pcb fop point to the corresponding table's close function
+    pcb->file_descriptor[fd].flags = 0;     // terminal copies made by dup2 have no close of their own
     sti();
     return SUCCESS;
 }
@@ -631,13 +722,14 @@ int32_t getargs (uint8_t* buf, int32_t nbytes){
     cli();
     uint32_t i = 0;
     uint32_t count = 0; 
-    while(i < nbytes){  // clear any extra newlines
-        if(stored_buf[i] == '\n'){
-            stored_buf[i] = '\0';
+    uint8_t* args = current_pcb()->args;    // saved by execute, the next execute may reuse stored_buf
+    while(i < nbytes && i < ARGS_LEN){  // clear any extra newlines
+        if(args[i] == '\n'){
+            args[i] = '\0';
         }
         i++;
     }
-    uint8_t* ptr = stored_buf;
+    uint8_t* ptr = args;
     while (*ptr != '\0'){    // get command into user buffer
         if(count < nbytes){
             buf[count] = *ptr;
@@ -649,7 +741,7 @@ int32_t getargs (uint8_t* buf, int32_t nbytes){
         }
     }
     if(count == 0){
-        printf("Error, No arguments! \n");
+        klog(KLOG_WARN, "Error, No arguments!");
         sti();
         return -1; // if no arguments
     }
@@ -701,6 +793,7 @@ int32_t vidmap (uint8_t** screen_start){
                 }
                 vidmap_page_table[i] = vidmap_table_entry.val;
         }
+        vidmap_page_table[VDSO_PT_IDX] = vdso_pte();   // keep the time page mapped
 
         pd_entry_pt vid_mem_pt;
         vid_mem_pt.page_base_31_12 = ((uint32_t)vidmap_page_table/FOUR_KB); // 4GB/(2^20) = 4096
@@ -723,22 +816,48 @@ int32_t vidmap (uint8_t** screen_start){
     }
 }
 
-/* int32_t set_handler(int32_t signum, void* handler_address)
- * Inputs: not used, meant for extra credit signaling
- * Return Value: -1 failure
- * Function: none
- * */
-int32_t set_handler (int32_t signum, void* handler_address){
-    return -1;
-}
-
-/* int32_t sigreturn(void);
- * Inputs: not used, meant for extra credit signaling
- * Return Value: -1 failure
- * Function: none
+/* int32_t ioctl(int32_t fd, int32_t cmd, int32_t arg);
+ * Inputs: int32_t fd -- file descriptor number
+ *         int32_t cmd -- IOCTL_GET_MODE or IOCTL_SET_MODE
+ *         int32_t arg -- new TERM_RAW/TERM_NONBLOCK bits for IOCTL_SET_MODE
+ * Return Value: -1 -- bad fd, fd is not the terminal, or bad command
+ *          mode bits for IOCTL_GET_MODE, 0 for IOCTL_SET_MODE
+ *  Function: Gets or sets the input mode of a terminal fd. Raw mode makes reads return single
+ *            key events as they arrive, non-blocking makes reads return 0 when nothing is pending.
  */
-int32_t sigreturn (void){
-    return -1;
+int32_t ioctl (int32_t fd, int32_t cmd, int32_t arg){
+    cli();
+    pcb_struct* pcb = files_pcb();
+
+    if(fd < FD_STDIN || fd > FD_MAX || pcb->file_descriptor[fd].flags == 0){  //Check for bad input
+        sti();
+        return FAIL_NEG_ONE;
+    }
+    if(pcb->file_descriptor[fd].file_operations_table_pointer != &stdin_fop){ // only the keyboard has modes
+        sti();
+        return FAIL_NEG_ONE;
+    }
+
+    switch (cmd)
+    {
+    case IOCTL_GET_MODE:
+        sti();
+        return pcb->file_descriptor[fd].mode;
+    case IOCTL_SET_MODE:
+        if(arg & ~TERM_MODE_MASK){
+            sti();
+            return FAIL_NEG_ONE;
+        }
+        if((arg ^ pcb->file_descriptor[fd].mode) & TERM_RAW){   // drop input typed in the old mode
+            terminal_raw_flush(pcb->terminal_num);
+        }
+        pcb->file_descriptor[fd].mode = arg;
+        sti();
+        return 0;
+    default:
+        sti();
+        return FAIL_NEG_ONE;
+    }
 }
 
 /* int32_t invalid_terminal_read(int32_t fd, void* buf, int32_t n);
@@ -759,10 +878,398 @@ int32_t invalid_terminal_read(int32_t fd, void* buf, int32_t n){
     return FAIL_NEG_ONE;
 }
 
+/* int32_t alloc_fd(fop_table_t* fop, uint32_t inode, uint32_t position);
+ * Inputs: fop_table_t* fop -- file operations of the new descriptor
+ *         uint32_t inode -- inode field, meaning is up to fop
+ *         uint32_t position -- initial file position
+ * Return Value: the new file descriptor, -1 if none is free
+ *  Function: takes the lowest free descriptor of the current process, shared by its threads */
+int32_t alloc_fd(fop_table_t* fop, uint32_t inode, uint32_t position){
+    pcb_struct* pcb = files_pcb();
+    int32_t fd;
+
+    for(fd = FD_MIN; fd <= FD_MAX; fd++){     //Find an open slot in the fd
+        if(pcb->file_descriptor[fd].flags == 0){
+            pcb->file_descriptor[fd].file_operations_table_pointer = fop;
+            pcb->file_descriptor[fd].inode = inode;
+            pcb->file_descriptor[fd].file_position = position;
+            pcb->file_descriptor[fd].flags = 1; // descriptor in-use
+            pcb->file_descriptor[fd].mode = 0;
+            return fd;
+        }
+    }
+    return FAIL_NEG_ONE;
+}
+
+/* int32_t user_buffer_ok(const void* buf, uint32_t n);
+ * Inputs: const void* buf -- pointer from a user program
+ *         uint32_t n -- size of the buffer in bytes
+ * Return Value: 1 if the whole buffer is in the program's 4MB page, 0 if not
+ *  Function: checks a pointer before the kernel keeps or follows it */
+int32_t user_buffer_ok(const void* buf, uint32_t n){
+    uint32_t addr = (uint32_t)buf;
+    return addr >= MB_128 && n <= ONE_THIRTY_TWO_MB - MB_128 && addr <= ONE_THIRTY_TWO_MB - n;
+}
+
+/* int32_t device_open(const uint8_t* filename);
+ * Inputs: const uint8_t* filename -- name of a virtual file
+ * Return Value: the new file descriptor, -1 if there is no such file
+ *  Function: opens a file from device_files */
+int32_t device_open(const uint8_t* filename){
+    int32_t idx;
+    for(idx = 0; device_files[idx].name != NULL; idx++){
+        if(!strncmp((const int8_t*)filename, device_files[idx].name, DENTRY_FILE_NAME_LEN)){
+            return device_files[idx].fop->open(filename);
+        }
+    }
+    return FAIL_NEG_ONE;
+}
+
+/* pcb_struct* task_pcb(int32_t pid);
+ * Inputs: int32_t pid -- process, thread or kernel thread
+ * Return Value: its PCB, NULL if pid is out of range or not in use
+ *  Function: looks up a task for code that lists or inspects tasks by pid */
+pcb_struct* task_pcb(int32_t pid){
+    pcb_struct* pcb;
+
+    if(pid < 0 || pid >= MAX_TASKS){
+        return NULL;
+    }
+    pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1));
+    return (pcb->active && pcb->pid == pid) ? pcb : NULL;
+}
 
+/* void vfile_begin(vfile_t* vf, int32_t fd, void* buf, int32_t nbytes);
+ * Inputs: vfile_t* vf -- read to start
+ *         int32_t fd -- descriptor of the virtual file, its position is where the read starts
+ *         void* buf -- user buffer
+ *         int32_t nbytes -- its size
+ * Return Value: none
+ *  Function: sets up a virtual file read for vfile_printf */
+void vfile_begin(vfile_t* vf, int32_t fd, void* buf, int32_t nbytes){
+    vf->buf = (uint8_t*)buf;
+    vf->start = files_pcb()->file_descriptor[fd].file_position;
+    vf->end = vf->start + ((nbytes > 0) ? nbytes : 0);
+    if(vf->start == VFILE_EOF){
+        vf->end = 0;                // an earlier read reached the end, nothing is copied
+    }
+    vf->off = 0;
+}
 
+/* void vfile_printf(vfile_t* vf, const int8_t* format, ...);
+ * Inputs: vfile_t* vf -- read in progress
+ *         const int8_t* format -- printf style format, the result is cut at VFILE_PIECE - 1
+ * Return Value: none
+ *  Function: adds text to the file, copying the part of it the read covers */
+void vfile_printf(vfile_t* vf, const int8_t* format, ...){
+    int8_t piece[VFILE_PIECE];
+    uint32_t len, from, to;
+    va_list ap;
+
+    if(vf->off >= vf->end){
+        return;                     // past what this read wants
+    }
+    va_start(ap, format);
+    len = vsnprintf(piece, sizeof(piece), format, ap);
+    va_end(ap);
+    if(len >= sizeof(piece)) len = sizeof(piece) - 1;
+
+    from = (vf->off > vf->start) ? vf->off : vf->start;
+    to = (vf->off + len < vf->end) ? vf->off + len : vf->end;
+    if(from < to){
+        memcpy(vf->buf + (from - vf->start), piece + (from - vf->off), to - from);
+    }
+    vf->off += len;
+}
 
+/* int32_t vfile_end(vfile_t* vf, int32_t fd);
+ * Inputs: vfile_t* vf -- read in progress
+ *         int32_t fd -- descriptor of the virtual file
+ * Return Value: bytes read, 0 at the end of the file
+ *  Function: finishes the read and moves the file position past it. A read that reached the
+ *            end of the text leaves the position at VFILE_EOF, so the next read returns 0
+ *            even if the text has grown since. */
+int32_t vfile_end(vfile_t* vf, int32_t fd){
+    uint32_t to = (vf->off < vf->end) ? vf->off : vf->end;
+    int32_t count = (to > vf->start) ? to - vf->start : 0;
+
+    if(vf->off < vf->end){
+        files_pcb()->file_descriptor[fd].file_position = VFILE_EOF;
+    }else{
+        files_pcb()->file_descriptor[fd].file_position += count;
+    }
+    return count;
+}
 
+/* void copy_fd(file_descriptor* dst, const file_descriptor* src);
+ * Inputs: file_descriptor* dst -- descriptor to fill, already free
+ *         const file_descriptor* src -- open descriptor
+ * Return Value: none
+ *  Function: makes dst another reference to the file of src */
+void copy_fd(file_descriptor* dst, const file_descriptor* src){
+    *dst = *src;
+    pipe_dup(dst);
+}
 
+/* void setup_std_fds(pcb_struct* pcb, pcb_struct* parent);
+ * Inputs: pcb_struct* pcb -- new process
+ *         pcb_struct* parent -- process or thread to inherit stdin and stdout from, NULL for
+ *                               the terminal
+ * Return Value: none
+ *  Function: opens stdin and stdout of a new process and frees the rest of its descriptors */
+void setup_std_fds(pcb_struct* pcb, pcb_struct* parent){
+    int32_t fd;
+
+    for(fd = FD_MIN; fd <= FD_MAX; fd++){
+        pcb->file_descriptor[fd].flags = 0;
+    }
+    if(parent == NULL){
+        pcb->file_descriptor[0].file_operations_table_pointer = &stdin_fop; //manually open stdin
+        pcb->file_descriptor[0].flags = 1;
+        pcb->file_descriptor[0].mode = 0;   // line mode, blocking
+        pcb->file_descriptor[1].file_operations_table_pointer = &stdout_fop; //manually open stdout
+        pcb->file_descriptor[1].flags = 1;
+        pcb->file_descriptor[1].mode = 0;
+        return;
+    }
+    for(fd = FD_STDIN; fd < FD_MIN; fd++){
+        copy_fd(&pcb->file_descriptor[fd], &group_leader(parent)->file_descriptor[fd]);
+        pcb->file_descriptor[fd].mode = 0;  // every program starts in line mode
+    }
+}
 
+/* int32_t dup2(int32_t old_fd, int32_t new_fd);
+ * Inputs: int32_t old_fd -- open descriptor
+ *         int32_t new_fd -- descriptor to replace, 0 and 1 included
+ * Return Value: new_fd, -1 for a bad descriptor or an RTC file
+ *  Function: closes new_fd if it is open and makes it refer to the file of old_fd. A shell
+ *            uses it to point stdin or stdout at a pipe before starting a program */
+int32_t dup2(int32_t old_fd, int32_t new_fd){
+    pcb_struct* pcb = files_pcb();
 
+    if(old_fd < FD_STDIN || old_fd > FD_MAX || new_fd < FD_STDIN || new_fd > FD_MAX){
+        return FAIL_NEG_ONE;
+    }
+    if(pcb->file_descriptor[old_fd].flags == 0){
+        return FAIL_NEG_ONE;
+    }
+    if(pcb->file_descriptor[old_fd].file_operations_table_pointer == &rtc_fop){  // a virtual timer has one owner
+        return FAIL_NEG_ONE;
+    }
+    if(old_fd == new_fd){
+        return new_fd;
+    }
+    cli();
+    if(pcb->file_descriptor[new_fd].flags == 1){
+        pcb->file_descriptor[new_fd].file_operations_table_pointer->close(new_fd);
+    }
+    copy_fd(&pcb->file_descriptor[new_fd], &pcb->file_descriptor[old_fd]);
+    sti();
+    return new_fd;
+}
+
+/* int32_t spawn(const uint8_t* command);
+ * Inputs: const uint8_t* command -- program name and arguments, as for execute
+ * Return Value: pid of the new process, -1 if the program cannot be run or nothing is free
+ *  Function: starts a program in a background slot and returns at once. The child shares the
+ *            caller's terminal and inherits its stdin and stdout, the scheduler enters it on
+ *            its next turn. */
+int32_t spawn(const uint8_t* command){
+    pcb_struct* parent = current_pcb();
+    pcb_struct* pcb;
+    dentry_t curr_dentry;
+    uint8_t file_name[DENTRY_FILE_NAME_LEN + 1];
+    uint8_t buffer[EXC_META];
+    uint32_t entry_point;
+    int32_t pid, slot;
+
+    if(!user_buffer_ok(command, 1)){
+        return FAIL_NEG_ONE;
+    }
+    cli();
+    parse_args(command);
+    strncpy((int8_t*)file_name, (const int8_t*)get_file_name(command), DENTRY_FILE_NAME_LEN);
+    file_name[DENTRY_FILE_NAME_LEN] = '\0';
+
+    // same checks as execute
+    if(read_dentry_by_name(file_name, &curr_dentry) == -1){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+    read_data(curr_dentry.inode_num, 0, buffer, FOURTY_BYTES);
+    if(is_executable(buffer) != 0){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+    memcpy(&entry_point, &buffer[ENTRY_POINT_BYTE], FOUR_BYTES);
+
+    slot = alloc_background_slot();
+    if(slot == -1){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+    for(pid = 0; pid < MAX_PCB; pid++){
+        if(!((pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1)))->active){
+            break;
+        }
+    }
+    if(pid == MAX_PCB){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+
+    // Load the program through the child's page, then give the caller its page back
+    paging_execute(pid);
+    read_data(curr_dentry.inode_num, 0, (uint8_t*)EXECUTE_ADDR, ((inodes_struct_ptr + curr_dentry.inode_num))->length);
+    paging_execute(group_leader(parent)->pid);
+
+    pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1));
+    pcb->pid = pid;
+    pcb->parent_id = parent->pid;
+    pcb->active = 1;
+    pcb->entry_point = entry_point;
+    pcb->is_shell = 0;
+    pcb->is_base_shell = 0;
+    pcb->terminal_num = parent->terminal_num;
+    pcb->pingpong = 0;
+    pcb->state = PROC_RUNNABLE;
+    pcb->on_timer_queue = 0;
+    pcb->timer_next = NULL;
+    pcb->uring = NULL;
+    pcb->wait_next = NULL;
+    pcb->wait_queue = NULL;
+    pcb->slot = slot;
+    pcb->spawned = 1;
+    pcb->fresh = 1;
+    pcb->shm_attached = 0;
+    pcb->shm_held = 0;
+    pcb->futex_addr = 0;
+    pcb->sig_pending = 0;
+    pcb->sig_blocked = 0;
+    memset(pcb->sig_handler, 0, sizeof(pcb->sig_handler));
+    pcb->zombie = 0;
+    pcb->in_waitpid = 0;
+    pcb->first_child = NULL;
+    pcb->kthread = 0;
+    pcb->group_leader = NULL;
+    pcb->next_thread = NULL;
+    fpu_release(pcb);
+    pcb->next_sibling = parent->first_child;
+    parent->first_child = pcb;
+    strncpy((int8_t*)pcb->args, (const int8_t*)stored_buf, ARGS_LEN - 1);
+    pcb->args[ARGS_LEN - 1] = '\0';
+    strncpy((int8_t*)pcb->name, (const int8_t*)curr_dentry.filename, DENTRY_FILE_NAME_LEN);
+    pcb->name[DENTRY_FILE_NAME_LEN] = '\0';
+    sysstat_clear(pcb);
+    pcb->sched_ticks = 0;
+    pcb->sched_switches = 0;
+    setup_std_fds(pcb, parent);
+    schedule_array[slot] = pid;     // runnable from the next PIT tick
+    sti();
+    return pid;
+}
+
+/* void halt_spawned(pcb_struct* pcb, int32_t status);
+ * Inputs: pcb_struct* pcb -- the halting process, started by spawn
+ *         int32_t status -- exit status for waitpid
+ * Return Value: does not return
+ *  Function: closes the files of the process and frees its slot. The pid stays taken as a
+ *            zombie until the parent collects the status with waitpid, or is freed at once
+ *            if the parent is gone. It then hands the CPU to the next task through
+ *            schedule_exit, the scheduler never comes back to a free slot. Called with
+ *            interrupts disabled. */
+void halt_spawned(pcb_struct* pcb, int32_t status){
+    pcb_struct* parent;
+    int32_t fd;
+
+    for(fd = 0; fd <= FD_MAX; fd++){
+        if(pcb->file_descriptor[fd].flags == 1){
+            pcb->file_descriptor[fd].file_operations_table_pointer->close(fd);
+        }
+    }
+    shm_detach_all(pcb);
+    release_children(pcb);
+    fpu_release(pcb);
+    schedule_array[pcb->slot] = SLOT_FREE;
+    pcb->spawned = 0;
+    if(pcb->parent_id == -1){
+        pcb->active = 0;                // orphan, nobody waits for it
+    }else{
+        pcb->exit_status = status;
+        pcb->zombie = 1;
+        parent = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pcb->parent_id+1));
+        if(parent->in_waitpid){
+            wake_process(parent);
+        }
+    }
+    schedule_exit();
+}
+
+/* void release_children(pcb_struct* pcb);
+ * Inputs: pcb_struct* pcb -- halting process
+ * Return Value: none
+ *  Function: frees the zombies among its spawned children and orphans the live ones, which
+ *            then free themselves when they halt. Called with interrupts disabled. */
+void release_children(pcb_struct* pcb){
+    pcb_struct* child;
+
+    for(child = pcb->first_child; child != NULL; child = child->next_sibling){
+        if(child->zombie){
+            child->zombie = 0;
+            child->active = 0;
+        }else{
+            child->parent_id = -1;
+        }
+    }
+    pcb->first_child = NULL;
+}
+
+/* int32_t waitpid(int32_t pid, int32_t* status, int32_t options);
+ * Inputs: int32_t pid -- spawned child to wait for, WAIT_ANY for any of them
+ *         int32_t* status -- where to store its exit status in the user page, may be NULL
+ *         int32_t options -- WNOHANG to return 0 instead of sleeping
+ * Return Value: pid of the collected child, 0 with WNOHANG if none has halted yet, -1 if
+ *               there is no such child, status is a bad pointer or a signal arrived first
+ *  Function: system call, collects a halted child started by spawn and frees its pid */
+int32_t waitpid(int32_t pid, int32_t* status, int32_t options){
+    pcb_struct* pcb = current_pcb();
+    pcb_struct** link;
+    pcb_struct* child;
+    int32_t found;
+
+    if(status != NULL && !user_buffer_ok(status, sizeof(int32_t))){
+        return FAIL_NEG_ONE;
+    }
+    cli();
+    while(1){
+        found = 0;
+        for(link = &pcb->first_child; *link != NULL; link = &(*link)->next_sibling){
+            child = *link;
+            if(pid != WAIT_ANY && child->pid != pid){
+                continue;
+            }
+            found = 1;
+            if(child->zombie){
+                *link = child->next_sibling;
+                child->zombie = 0;
+                child->active = 0;
+                if(status != NULL){
+                    *status = child->exit_status;
+                }
+                sti();
+                return child->pid;
+            }
+        }
+        if(!found || (options & WNOHANG)){
+            sti();
+            return found ? 0 : FAIL_NEG_ONE;
+        }
+        pcb->in_waitpid = 1;
+        if(block_current(TIMER_NO_DEADLINE) == -1){
+            pcb->in_waitpid = 0;
+            sti();
+            return FAIL_NEG_ONE;
+        }
+        pcb->in_waitpid = 0;
+    }
+}
@@ -30,6 +30,8 @@
 #define EXECUTE_ADDR    0x08048000
 #define BUFSIZE 1024
 #define MAX_PCB     512
+#define WAIT_ANY    -1          // waitpid: any spawned child
+#define WNOHANG     1           // waitpid: do not sleep
 #define SHELL_LIMIT 6
 #define PROGRAM_LIMIT 6
 #define FIVE_BYTES 5
@@ -37,6 +39,7 @@
 #define RTC 0
 #define DIRECTORY 1
 #define FILE 2
+#define PROC_FILE 3
 #define PROCESS_NUMBER_PIT 3
 #define CAT_STRLEN 3
 
@@ -60,6 +63,10 @@ int32_t is_executable(uint8_t* buffer);
 extern void flush_tlb();
 extern void context_switch();
 void disable_child_page();
+void copy_fd(file_descriptor* dst, const file_descriptor* src);
+void setup_std_fds(pcb_struct* pcb, pcb_struct* parent);
+void halt_spawned(pcb_struct* pcb, int32_t status);
+void release_children(pcb_struct* pcb);
 
 // system call functions
 extern int32_t system_halt (uint8_t status);
@@ -76,8 +83,38 @@ int32_t invalid_terminal_write(int32_t fd, const void* buf, int32_t n);
 int32_t getargs (uint8_t* buf, int32_t nbytes);
 int32_t vidmap (uint8_t** screen_start);
 // int32_t switch_vidmap(uint32_t terminal_num);
-int32_t set_handler (int32_t signum, void* handler_address);
-int32_t sigreturn (void);
+int32_t ioctl (int32_t fd, int32_t cmd, int32_t arg);
+int32_t dup2(int32_t old_fd, int32_t new_fd);
+int32_t spawn(const uint8_t* command);
+int32_t waitpid(int32_t pid, int32_t* status, int32_t options);
+int32_t alloc_fd(fop_table_t* fop, uint32_t inode, uint32_t position);
+int32_t device_open(const uint8_t* filename);
+int32_t user_buffer_ok(const void* buf, uint32_t n);
+pcb_struct* task_pcb(int32_t pid);
+
+#define MAX_TASKS   32      // pids task_pcb looks at, more than there are user pages in memory
+#define VFILE_PIECE 96      // longest text one vfile_printf adds
+#define VFILE_EOF   0xFFFFFFFF  // file position once a read has reached the end of the text
+
+/* A read of a virtual file whose text is generated again on every read. vfile_printf
+ * produces the text from its start and only the part from the file position on, up to the
+ * size of the user buffer, is copied out. */
+typedef struct vfile_t {
+    uint8_t* buf;           // user buffer
+    uint32_t start;         // file position, offset of buf[0] in the text
+    uint32_t end;           // start plus the size of buf
+    uint32_t off;           // text produced so far
+} vfile_t;
+
+void vfile_begin(vfile_t* vf, int32_t fd, void* buf, int32_t nbytes);
+void vfile_printf(vfile_t* vf, const int8_t* format, ...);
+int32_t vfile_end(vfile_t* vf, int32_t fd);
+
+/* a file that exists only in the kernel, see device_files */
+typedef struct device_file_t {
+    const int8_t* name;
+    fop_table_t* fop;
+} device_file_t;
 
 /* file operations tables for different types of files
  *  stdin_fop  -- read-only terminal
@@ -91,6 +128,10 @@ extern fop_table_t stdout_fop;
 extern fop_table_t rtc_fop;
 extern fop_table_t directory_fop;
 extern fop_table_t file_fop;
+extern fop_table_t klog_fop;
+extern fop_table_t prof_fop;
+extern fop_table_t sysstat_fop;
+extern fop_table_t procfs_fop;
 
 #endif /* SYSTEM_CALL_H */
 
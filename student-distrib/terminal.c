@@ -7,6 +7,11 @@
 #include "terminal.h"
 #include "scheduling.h"
 #include "system_call.h"
+#include "serial.h"
+#include "timer.h"
+#include "poll.h"
+#include "thread.h"
+#include "signal.h"
 
 // Global variables used by different terminals
 int32_t bytes_written, line_ct;     
@@ -15,6 +20,9 @@ extern uint8_t row_letter_ct;
 int32_t pingpong_terminal;
 int8_t hello_flag = 0;
 
+int32_t terminal_read_raw(int32_t term, void* buf, int32_t n, uint32_t mode);
+int32_t terminal_line_ready(int32_t term);
+
 /* int terminal_open()
  * opens the terminal
  * inputs: none
@@ -52,7 +60,8 @@ int32_t terminal_close(int32_t fd){
  * copies the keyboard buffer into buf
  * inputs: char buf[128] -- the buffer to fill
  *          n -- how many chars to copy
- * outputs: buffer_ct + 1 -- current size of the copied buffer
+ * outputs: buffer_ct + 1 -- current size of the copied buffer, -1 if a signal arrived before
+ *          the line was entered
  * side effects: none
  */
 int32_t terminal_read(int32_t fd, void* buf, int n){
@@ -62,14 +71,29 @@ int32_t terminal_read(int32_t fd, void* buf, int n){
 
     // Get the pcb of the scheduled process for later use
     pcb_struct* current_pcb_local;
-    current_pcb_local = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[schedule_idx].curr_pid +1));   
+    current_pcb_local = current_pcb();   
     terminal[current_pcb_local->terminal_num].terminal_buf = (uint8_t*)buf;
+    uint32_t mode = files_pcb()->file_descriptor[fd].mode;
+
+    // Raw mode hands out queued key events instead of a line
+    if(mode & TERM_RAW){
+        return terminal_read_raw(current_pcb_local->terminal_num, buf, n, mode);
+    }
+
+    // Non-blocking line read: nothing to hand out until enter is pressed
+    if((mode & TERM_NONBLOCK) && !terminal_line_ready(current_pcb_local->terminal_num)){
+        enable_irq(0);
+        return 0;
+    }
     
     // Wait until the enter is pressed and terminal number matches with schedule index
     while(1){
         disable_irq(0);
-        if(!terminal[current_pcb_local->terminal_num].enter_read || !(terminal_num == schedule_idx)){
+        if(!terminal_line_ready(current_pcb_local->terminal_num)){
             enable_irq(0);
+            if(signal_pending(current_pcb_local)){
+                return -1;
+            }
         }else{
             break;
         }
@@ -97,16 +121,148 @@ int32_t terminal_read(int32_t fd, void* buf, int n){
     
     //If it's exit, add a \0 to the end
     if(strncmp(buf, (char*)"exit\n", SIX_BYTE) == 0){
-        ((char*)buf)[terminal[terminal_num].buffer_ct] = '\0';   //add the newline   
+        ((char*)buf)[terminal[current_pcb_local->terminal_num].buffer_ct] = '\0';   //add the newline   
     }     
     
-    clear_buffer();  //clear the keyboard_buffer
+    clear_buffer(current_pcb_local->terminal_num);  //clear the keyboard_buffer
     terminal[current_pcb_local->terminal_num].enter_read = 0;    //flip enter flag
     
     enable_irq(0);
     return saved_buffer_ct+1;
 } 
 
+/* int terminal_line_ready()
+ * whether a line is waiting for the reader of a terminal
+ * inputs: int32_t term -- terminal index
+ * outputs: 1 once enter was pressed and the terminal is on screen or fed by COM1, else 0
+ * side effects: none
+ */
+int32_t terminal_line_ready(int32_t term){
+    if(!terminal[term].enter_read){
+        return 0;
+    }
+    return (terminal_num == schedule_idx) || (term == SERIAL_TERMINAL && serial_is_present());
+}
+
+/* int terminal_read_raw()
+ * copies pending key events of a raw mode terminal into buf
+ * inputs: int32_t term -- terminal the reader belongs to
+ *         void* buf -- the buffer to fill, one scan code per byte
+ *         int32_t n -- maximum number of events to copy
+ *         uint32_t mode -- mode bits of the fd, TERM_NONBLOCK returns 0 when nothing is queued
+ * outputs: number of events copied, -1 if a signal arrived while waiting for one
+ * side effects: consumes events from the terminal's raw ring
+ */
+int32_t terminal_read_raw(int32_t term, void* buf, int32_t n, uint32_t mode){
+    int32_t count = 0;
+
+    if(n <= 0){
+        enable_irq(0);
+        return 0;
+    }
+
+    // Wait for at least one event unless the reader asked not to block
+    while(1){
+        disable_irq(0);
+        if(terminal[term].raw_head == terminal[term].raw_tail){
+            enable_irq(0);
+            if(mode & TERM_NONBLOCK){
+                return 0;
+            }
+            if(signal_pending(current_pcb())){
+                return -1;
+            }
+        }else{
+            break;
+        }
+    }
+
+    while((count < n) && (terminal[term].raw_head != terminal[term].raw_tail)){
+        ((uint8_t*)buf)[count] = terminal[term].raw_events[terminal[term].raw_head & (RAW_EVENT_LIM - 1)];
+        terminal[term].raw_head++;
+        count++;
+    }
+
+    enable_irq(0);
+    return count;
+}
+
+/* int terminal_mode()
+ * mode bits of the stdin of the process in the foreground of a terminal
+ * inputs: int32_t term -- terminal index
+ * outputs: TERM_RAW/TERM_NONBLOCK bits, 0 for a line mode terminal
+ * side effects: none
+ */
+int32_t terminal_mode(int32_t term){
+    pcb_struct* pcb;
+
+    if(pit_count <= term){      // shell of this terminal not launched yet
+        return 0;
+    }
+    pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[term].curr_pid +1));
+    if(pcb->file_descriptor[0].flags == 0 || pcb->file_descriptor[0].file_operations_table_pointer != &stdin_fop){
+        return 0;
+    }
+    return pcb->file_descriptor[0].mode;
+}
+
+/* int terminal_poll()
+ * readiness of a terminal opened for reading
+ * inputs: int32_t fd -- stdin descriptor of the current process
+ * outputs: POLLIN once a read would not block, else 0
+ * side effects: none
+ */
+int32_t terminal_poll(int32_t fd){
+    pcb_struct* pcb = current_pcb();
+    int32_t term = pcb->terminal_num;
+
+    if(files_pcb()->file_descriptor[fd].mode & TERM_RAW){
+        return (terminal[term].raw_head != terminal[term].raw_tail) ? POLLIN : 0;
+    }
+    return terminal_line_ready(term) ? POLLIN : 0;
+}
+
+/* int terminal_write_poll()
+ * readiness of a terminal opened for writing
+ * inputs: int32_t fd -- stdout descriptor, not used
+ * outputs: POLLOUT, writes go straight to the screen
+ * side effects: none
+ */
+int32_t terminal_write_poll(int32_t fd){
+    return POLLOUT;
+}
+
+/* void terminal_raw_push()
+ * queues a key event for a raw mode reader, dropping it if the ring is full
+ * inputs: int32_t term -- terminal index
+ *         uint8_t scan_code -- the key event
+ * outputs: none
+ * side effects: advances raw_tail
+ */
+void terminal_raw_push(int32_t term, uint8_t scan_code){
+    if(terminal[term].raw_tail - terminal[term].raw_head >= RAW_EVENT_LIM){
+        return;
+    }
+    terminal[term].raw_events[terminal[term].raw_tail & (RAW_EVENT_LIM - 1)] = scan_code;
+    terminal[term].raw_tail++;
+}
+
+/* void terminal_raw_flush()
+ * drops queued raw key events and the pending line of a terminal
+ * inputs: int32_t term -- terminal index
+ * outputs: none
+ * side effects: empties the raw ring and the keyboard buffer
+ */
+void terminal_raw_flush(int32_t term){
+    int32_t idx;
+    terminal[term].raw_head = terminal[term].raw_tail;
+    for(idx = 0; idx < BUFFER_LIM - 1; idx++){
+        terminal[term].keyboard_buffer[idx] = NULL;
+    }
+    terminal[term].buffer_ct = 0;
+    terminal[term].enter_read = 0;
+}
+
 /* int terminal_write()
  * writes buf into the terminal
  * inputs: char buf[128] -- the input buffer
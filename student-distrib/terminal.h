@@ -8,9 +8,21 @@
 #define COUNTER_BYTE_COUNT 58
 #define EXIT_BYTE_COUNT 5
 
+/* ioctl commands and terminal mode bits */
+#define IOCTL_GET_MODE  0
+#define IOCTL_SET_MODE  1
+#define TERM_RAW        0x1     // reads return single key events (scan codes), no echo
+#define TERM_NONBLOCK   0x2     // reads return 0 instead of waiting
+#define TERM_MODE_MASK  (TERM_RAW | TERM_NONBLOCK)
+
 int32_t terminal_open();
 int32_t terminal_close();
 int32_t terminal_read(int fd, void* buf, int n);
 int32_t terminal_write(int fd, const void* buf, int n);
+int32_t terminal_mode(int32_t term);
+int32_t terminal_poll(int32_t fd);
+int32_t terminal_write_poll(int32_t fd);
+void terminal_raw_push(int32_t term, uint8_t scan_code);
+void terminal_raw_flush(int32_t term);
 
 
@@ -9,6 +9,26 @@
 #include "terminal.h"
 #include "keyboard.h"
 #include "system_call.h"
+#include "klog.h"
+#include "scheduling.h"
+#include "clock.h"
+#include "vdso.h"
+#include "timer.h"
+#include "pit.h"
+#include "sysenter.h"
+#include "uring.h"
+#include "pipe.h"
+#include "kthread.h"
+#include "thread.h"
+#include "fpu.h"
+#include "prof.h"
+#include "sysstat.h"
+#include "procfs.h"
+#include "shm.h"
+#include "futex.h"
+#include "poll.h"
+#include "signal.h"
+#include "idt_number.h"
 
 #define PASS 				1
 #define FAIL 				0
@@ -1098,6 +1118,815 @@ int system_rtc_test(){
 /* Checkpoint 4 tests */
 /* Checkpoint 5 tests */
 
+/* test_fixture_pcb
+ * 
+ * Marks stdin and stdout open on the PCB of the process in front of the scheduled terminal,
+ * so a test can open and read files as that process
+ * Inputs: None
+ * Outputs: the PCB
+ * Side Effects: sets the flags of file descriptors 0 and 1
+ */
+static pcb_struct* test_fixture_pcb(void){
+	pcb_struct* pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(terminal[schedule_idx].curr_pid +1));
+	pcb->file_descriptor[0].flags = 1;
+	pcb->file_descriptor[1].flags = 1;
+	return pcb;
+}
+
+/* klog Test
+ * 
+ * Logs two records and reads them back through the "klog" virtual file, after an empty read
+ * and a read too small for a record that must not use the record up
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: klog, klog_open, klog_read
+ * Files: klog.c/h
+ */
+int klog_test(){
+	TEST_HEADER;
+	uint8_t name[FNAME_LENGTH] = "klog";
+	static uint8_t buf[KLOG_SLOTS * (KLOG_MSG_LEN + 3)];	// too big for the kernel stack
+	int32_t fd, count, i;
+	int32_t found = 0;
+
+	test_fixture_pcb();
+
+	klog(KLOG_DEBUG, "klog test %d", 391);
+	klog(KLOG_ERR, "klog test %s", "done");
+	fd = open(name);
+	if(fd == -1) return FAIL;
+	if(read(fd, buf, 0) != 0) return FAIL;
+	if(read(fd, buf, 4) != -1) return FAIL;
+	count = read(fd, buf, sizeof(buf));
+	for(i = 0; i + 17 <= count; i++){
+		if(!strncmp((int8_t*)&buf[i], "D klog test 391\n", 16)) found++;
+		if(!strncmp((int8_t*)&buf[i], "E klog test done\n", 17)) found++;
+	}
+	if(read(fd, buf, sizeof(buf)) != 0) found = 0;	// everything was read the first time
+	close(fd);
+	return (found == 2) ? PASS : FAIL;
+}
+
+/* rtc_wheel Test
+ * 
+ * Runs 1024 simulated ticks with a 1024 Hz and a 2 Hz RTC file open
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: rtc_open, rtc_write, rtc_close, rtc_bottom_half
+ * Files: rtc.c/h
+ */
+int rtc_wheel_test(){
+	TEST_HEADER;
+	uint8_t name[FNAME_LENGTH] = "rtc";
+	int32_t fast_rate = 1024;
+	int32_t slow_rate = 2;
+	int32_t fast, slow, result = PASS;
+	uint32_t fast_fired, slow_fired;
+	extern rtc_timer_t rtc_timers[RTC_MAX_TIMERS];
+	extern volatile uint32_t rtc_pending_ticks;
+
+	pcb_struct* pcb = test_fixture_pcb();
+
+	fast = open(name);
+	slow = open(name);
+	if(fast == -1 || slow == -1) return FAIL;
+	if(write(fast, &fast_rate, 4) == -1 || write(slow, &slow_rate, 4) == -1) result = FAIL;
+
+	cli();		// real ticks wait in the top half until the end of the test
+	rtc_timers[pcb->file_descriptor[fast].inode].fired = 0;
+	rtc_timers[pcb->file_descriptor[slow].inode].fired = 0;
+	rtc_pending_ticks += MAX_FREQUENCY;
+	rtc_bottom_half();
+	fast_fired = rtc_timers[pcb->file_descriptor[fast].inode].fired;
+	slow_fired = rtc_timers[pcb->file_descriptor[slow].inode].fired;
+	sti();
+
+	if(fast_fired != fast_rate || slow_fired != slow_rate) result = FAIL;
+	close(fast);
+	close(slow);
+	return result;
+}
+
+/* clock Test
+ * 
+ * Checks that the TSC clock is calibrated, monotonic and splits seconds correctly
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: clock_ns, cycles_to_ns, div_u64
+ * Files: clock.c/h
+ */
+int clock_test(){
+	TEST_HEADER;
+	uint64_t before, after;
+	uint32_t rem;
+	int i;
+
+	if(tsc_khz == 0 || clock_mult == 0) return FAIL;
+	before = clock_ns();
+	for(i = 0; i < 1000; i++){
+		after = clock_ns();
+		if(after < before) return FAIL;
+		before = after;
+	}
+	if(div_u64(cycles_to_ns((uint64_t)tsc_khz * 1000), NS_PER_MS, NULL) < 999) return FAIL;	// one second of cycles
+	if(div_u64(5000000123ULL, NS_PER_SEC, &rem) != 5 || rem != 123) return FAIL;
+	return PASS;
+}
+
+/* vdso Test
+ * 
+ * Checks the time page mapping and that an update publishes consistent values
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: vdso_update, vdso_pte
+ * Files: vdso.c/h
+ */
+int vdso_test(){
+	TEST_HEADER;
+	pt_entry_page entry;
+	uint32_t seq;
+
+	entry.val = vidmap_page_table[VDSO_PT_IDX];
+	if(!entry.present || !entry.u_s || entry.r_w) return FAIL;	// user, read-only
+
+	seq = vdso_data->seq;
+	vdso_update();
+	if((vdso_data->seq & 1) || vdso_data->seq != seq + 2) return FAIL;
+	if(vdso_data->tsc_khz != tsc_khz || vdso_data->clock_mult != clock_mult) return FAIL;
+	if(vdso_data->tick_ns > clock_ns()) return FAIL;
+	return PASS;
+}
+
+/* timer_sleep Test
+ * 
+ * Blocks for 20 ms on the timer queue and checks the wake up time, then checks an early wake
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: needs the PIT tick running
+ * Coverage: block_current, wake_process, timer softirq
+ * Files: timer.c/h
+ */
+int timer_sleep_test(){
+	TEST_HEADER;
+	uint64_t start, elapsed;
+	uint64_t tick_ns = NS_PER_SEC / PIT_HZ;
+	pcb_struct* pcb = current_pcb();
+
+	start = clock_ns();
+	if(block_current(start + 20 * NS_PER_MS) != -1) return FAIL;	// ended by the deadline
+	sti();
+	elapsed = clock_ns() - start;
+	if(elapsed < 20 * NS_PER_MS || elapsed > 20 * NS_PER_MS + 2 * tick_ns) return FAIL;
+
+	pcb->state = PROC_BLOCKED;
+	wake_process(pcb);
+	if(pcb->state != PROC_RUNNABLE || pcb->timed_out) return FAIL;
+	return PASS;
+}
+
+/* sysenter Test
+ * 
+ * Reads the SYSENTER MSRs back and checks they point at the entry stub
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: sysenter_init
+ * Files: sysenter.c/h, intr_linkage.S
+ */
+int sysenter_test(){
+	TEST_HEADER;
+	uint32_t lo, hi;
+
+	if(!sysenter_enabled){
+		return (vdso_data->features & VDSO_FEAT_SYSENTER) ? FAIL : PASS;
+	}
+	if(!(vdso_data->features & VDSO_FEAT_SYSENTER)) return FAIL;
+	asm volatile ("rdmsr" : "=a"(lo), "=d"(hi) : "c"(MSR_SYSENTER_CS));
+	if(lo != KERNEL_CS) return FAIL;
+	asm volatile ("rdmsr" : "=a"(lo), "=d"(hi) : "c"(MSR_SYSENTER_EIP));
+	if(lo != (uint32_t)sysenter_entry || hi != 0) return FAIL;
+	asm volatile ("rdmsr" : "=a"(lo), "=d"(hi) : "c"(MSR_SYSENTER_ESP));
+	if(lo == 0) return FAIL;
+	return PASS;
+}
+
+/* uring Test
+ * 
+ * Checks that rings outside the user page are refused and that entering without rings fails
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: unregisters the rings of the current process
+ * Coverage: uring_setup, uring_enter, user_buffer_ok
+ * Files: uring.c/h, system_call.c
+ */
+int uring_test(){
+	TEST_HEADER;
+	static uring_t kernel_ring;
+
+	if(!user_buffer_ok((void*)MB_128, FOUR_MB)) return FAIL;
+	if(user_buffer_ok((void*)(MB_128 - 1), 2)) return FAIL;
+	if(user_buffer_ok((void*)(ONE_THIRTY_TWO_MB - 4), 8)) return FAIL;
+	if(user_buffer_ok((void*)MB_128, 0xFFFFFFFF)) return FAIL;
+	if(uring_setup(&kernel_ring) != -1) return FAIL;
+	if(uring_setup(NULL) != 0) return FAIL;
+	if(uring_enter(1) != -1) return FAIL;
+	return PASS;
+}
+
+/* pipe Test
+ * 
+ * Passes data through a pipe, across the end of the ring, then checks end of file
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: pipe_create, pipe_read, pipe_write, pipe_close
+ * Files: pipe.c/h
+ */
+int pipe_test(){
+	TEST_HEADER;
+	static uint8_t data[PIPE_BUF_SIZE];
+	static uint8_t out[PIPE_BUF_SIZE];
+	int32_t rd, wr, i;
+	uint32_t chunk = PIPE_BUF_SIZE * 3 / 4;
+
+	for(i = 0; i < PIPE_BUF_SIZE; i++){
+		data[i] = (uint8_t)(i * 7);
+	}
+	if(pipe_create(&rd, &wr) != 0) return FAIL;
+	if(pipe_write(wr, data, chunk) != chunk) return FAIL;
+	if(pipe_read(rd, out, PIPE_BUF_SIZE) != chunk) return FAIL;
+	for(i = 0; i < chunk; i++){
+		if(out[i] != data[i]) return FAIL;
+	}
+	if(pipe_write(wr, data, chunk) != chunk) return FAIL;		// wraps around the ring
+	if(pipe_read(rd, out, PIPE_BUF_SIZE) != chunk) return FAIL;
+	for(i = 0; i < chunk; i++){
+		if(out[i] != data[i]) return FAIL;
+	}
+	pipe_close(wr);
+	if(pipe_read(rd, out, PIPE_BUF_SIZE) != 0) return FAIL;		// no writers, end of file
+	pipe_close(rd);
+	return PASS;
+}
+
+
+/* shm Test
+ * 
+ * Creates, maps and frees a segment, then checks a new segment comes back zero filled
+ * and a segment that is never mapped is freed at halt
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: maps the segment at SHM_ADDR while the test runs
+ * Coverage: shm_find_or_create, shm_map, shm_detach, shm_detach_all, shm_switch
+ * Files: shm.c/h
+ */
+int shm_test(){
+	TEST_HEADER;
+	int32_t id;
+	uint8_t* addr;
+	uint32_t segs, pages, in_use;
+
+	id = shm_find_or_create((uint8_t*)"shm_test", SHM_PAGE_SIZE + 1);
+	if(id == -1) return FAIL;
+	if(shm_find_or_create((uint8_t*)"shm_test", 1) != id) return FAIL;
+	if(shm_find_or_create((uint8_t*)"shm_test", SHM_SEG_SIZE) != -1) return FAIL;	// larger than created
+	if(shm_find_or_create((uint8_t*)"too_big", SHM_SEG_SIZE + 1) != -1) return FAIL;
+	if(shm_get((uint8_t*)"shm_test", 1) != -1) return FAIL;						// name not in the user page
+
+	addr = shm_map(id);
+	if(addr != (uint8_t*)(SHM_ADDR + id * SHM_SEG_SIZE)) return FAIL;
+	if(shm_map(id) != addr) return FAIL;
+	addr[0] = 0x5A;
+	addr[SHM_PAGE_SIZE] = 0xA5;													// second page is mapped too
+	if(addr[0] != 0x5A || addr[SHM_PAGE_SIZE] != 0xA5) return FAIL;
+	if(shm_detach(id) != 0) return FAIL;
+	if(shm_detach(id) != -1) return FAIL;
+
+	id = shm_find_or_create((uint8_t*)"shm_test", 1);							// freed, so created again
+	addr = shm_map(id);
+	if(addr == NULL || addr[0] != 0) return FAIL;
+	if(shm_detach(id) != 0) return FAIL;
+
+	shm_usage(&in_use, &pages);
+	id = shm_find_or_create((uint8_t*)"shm_test", 1);							// got, never mapped
+	if(id == -1) return FAIL;
+	shm_usage(&segs, &pages);
+	if(segs != in_use + 1) return FAIL;
+	shm_detach_all(files_pcb());												// halt drops it
+	shm_usage(&segs, &pages);
+	if(segs != in_use || shm_detach(id) != -1) return FAIL;
+	return PASS;
+}
+
+/* futex Test
+ * 
+ * Checks futex keys through a shared segment, the calls that must not sleep and a wait
+ * that a pending signal ends
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: creates and frees a shared segment, clears the signal state of the current process
+ * Coverage: futex_wait, futex_wake, user_phys_addr, signal_pending
+ * Files: futex.c/h, paging.c
+ */
+int futex_test(){
+	TEST_HEADER;
+	static uint32_t kernel_word;
+	pcb_struct* pcb = current_pcb();
+	int32_t id;
+	uint32_t* word;
+
+	if(user_phys_addr((uint32_t)&kernel_word) != 0) return FAIL;		// supervisor page
+	if(futex_wait(&kernel_word, kernel_word) != -1) return FAIL;
+
+	id = shm_find_or_create((uint8_t*)"futex_test", SHM_PAGE_SIZE);
+	word = (uint32_t*)shm_map(id);
+	if(word == NULL) return FAIL;
+	if(user_phys_addr((uint32_t)&word[1]) != user_phys_addr((uint32_t)word) + sizeof(uint32_t)) return FAIL;
+	if(futex_wait((uint32_t*)((uint8_t*)word + 1), 0) != -1) return FAIL;	// misaligned
+	if(futex_wait(word, 1) != -1) return FAIL;							// word holds 0, no sleep
+	if(futex_wake(word, 1) != 0) return FAIL;							// nobody waits
+	pcb->sig_blocked = 0;
+	pcb->sig_pending = 1 << SIG_INTERRUPT;
+	if(futex_wait(word, 0) != -1 || pcb->futex_addr != 0) return FAIL;	// interrupted, not woken
+	pcb->sig_pending = 0;
+	if(shm_detach(id) != 0) return FAIL;
+	if(futex_wake(word, 1) != -1) return FAIL;							// unmapped now
+	return PASS;
+}
+
+/* poll Test
+ * 
+ * Scans a pipe through its life and a descriptor that is not open
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: poll_scan, pipe_poll, poll
+ * Files: poll.c/h, pipe.c
+ */
+int poll_test(){
+	TEST_HEADER;
+	static pollfd_t fds[3];
+	int32_t rd, wr;
+	uint8_t c = 'x';
+
+	if(pipe_create(&rd, &wr) != 0) return FAIL;
+	fds[0].fd = rd;
+	fds[0].events = POLLIN;
+	fds[1].fd = wr;
+	fds[1].events = POLLOUT;
+	fds[2].fd = FD_MAX + 1;
+	fds[2].events = POLLIN;
+	if(poll_scan(fds, 3) != 2) return FAIL;								// writable, bad fd
+	if(fds[0].revents != 0 || fds[1].revents != POLLOUT || fds[2].revents != POLLNVAL) return FAIL;
+
+	if(pipe_write(wr, &c, 1) != 1) return FAIL;
+	if(poll_scan(fds, 2) != 2 || fds[0].revents != POLLIN) return FAIL;
+	if(pipe_read(rd, &c, 1) != 1) return FAIL;
+	pipe_close(wr);
+	if(poll_scan(fds, 1) != 1 || fds[0].revents != (POLLIN | POLLHUP)) return FAIL;	// end of file
+	pipe_close(rd);
+	if(poll(fds, 1, 0) != -1) return FAIL;									// array not in the user page
+	return PASS;
+}
+
+/* signal Test
+ * 
+ * Raises signals with no handler and checks they wait for user mode and are then ignored,
+ * then that a signal wakes its target only when the target is blocked
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: clears the signal state of the current process
+ * Coverage: send_signal, do_signal, set_handler, signal_from_exception, wake_process
+ * Files: signal.c/h
+ */
+int signal_test(){
+	TEST_HEADER;
+	pcb_struct* pcb = current_pcb();
+	hw_context_t regs;
+
+	memset(&regs, 0, sizeof(regs));
+	pcb->sig_pending = 0;
+	pcb->sig_blocked = 0;
+	memset(pcb->sig_handler, 0, sizeof(pcb->sig_handler));
+	if(set_handler(NUM_SIGNALS, NULL) != -1) return FAIL;
+	if(set_handler(SIG_ALARM, (void*)signal_test) != -1) return FAIL;		// not in the user page
+	if(set_handler(SIG_ALARM, NULL) != 0) return FAIL;
+
+	send_signal(pcb, SIG_ALARM);
+	send_signal(pcb, SIG_USER1);
+	regs.cs = KERNEL_CS;
+	if(do_signal(&regs) != 0 || pcb->sig_pending != ((1 << SIG_ALARM) | (1 << SIG_USER1))) return FAIL;
+	if(signal_from_exception(page, &regs) != 0) return FAIL;				// kernel faults are not signals
+
+	regs.cs = USER_CS;
+	regs.eip = 0x1234;
+	pcb->sig_blocked = 1 << SIG_USER1;
+	if(do_signal(&regs) != 0 || pcb->sig_pending != (1 << SIG_USER1)) return FAIL;	// alarm ignored
+	if(regs.eip != 0x1234) return FAIL;
+	if(signal_from_exception(page, &regs) != 0) return FAIL;				// no SEGFAULT handler
+
+	pcb->sig_pending = 0;
+	pcb->sig_blocked = 0;
+	pcb->sig_woken = 0;
+	send_signal(pcb, SIG_INTERRUPT);
+	if(pcb->sig_woken != 0) return FAIL;									// running, nothing to wake
+	pcb->state = PROC_BLOCKED;
+	send_signal(pcb, SIG_INTERRUPT);
+	if(pcb->state != PROC_RUNNABLE || pcb->sig_woken != 1) return FAIL;	// woken by the signal
+	pcb->sig_pending = 0;
+	pcb->sig_woken = 0;
+	return PASS;
+}
+
+/* waitpid Test
+ * 
+ * Reaps a fake zombie child linked under the current process
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: waitpid
+ * Files: system_call.c/h
+ */
+int waitpid_test(){
+	TEST_HEADER;
+	static pcb_struct child;
+	pcb_struct* pcb = current_pcb();
+	pcb_struct* saved = pcb->first_child;
+	int result = PASS;
+
+	pcb->first_child = NULL;
+	if(waitpid(WAIT_ANY, NULL, WNOHANG) != -1) result = FAIL;		// no children
+
+	memset(&child, 0, sizeof(child));
+	child.pid = 5;
+	child.active = 1;
+	pcb->first_child = &child;
+	if(waitpid(WAIT_ANY, NULL, WNOHANG) != 0) result = FAIL;		// still running
+	if(waitpid(4, NULL, WNOHANG) != -1) result = FAIL;				// not our child
+	child.zombie = 1;
+	if(waitpid(5, NULL, 0) != 5) result = FAIL;
+	if(pcb->first_child != NULL || child.active != 0) result = FAIL;
+
+	pcb->first_child = saved;
+	return result;
+}
+
+/* thread function for kthread_test, never runs */
+static void kthread_test_fn(uint32_t data){
+}
+
+/* kthread Test
+ * 
+ * Creates a kernel thread and checks its PCB and slot, then removes it before it runs
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: kthread_create, alloc_kthread_slot
+ * Files: kthread.c/h, scheduling.c
+ */
+int kthread_test(){
+	TEST_HEADER;
+	pcb_struct* pcb;
+	int32_t pid;
+	int result = PASS;
+
+	cli();
+	pid = kthread_create(kthread_test_fn, 391, (const int8_t*)"ktest");
+	if(pid < PROCESS_NUMBER_PIT){
+		sti();
+		return FAIL;
+	}
+	pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1));
+	if(!pcb->kthread || !pcb->fresh || pcb->kthread_data != 391) result = FAIL;
+	if(pcb->slot < KTHREAD_SLOT_BASE || schedule_array[pcb->slot] != pid) result = FAIL;
+	if(strncmp((int8_t*)pcb->args, "ktest", 6)) result = FAIL;
+
+	schedule_array[pcb->slot] = SLOT_FREE;
+	pcb->kthread = 0;
+	pcb->active = 0;
+	sti();
+	return result;
+}
+
+/* thread Test
+ * 
+ * Rejects bad thread_create and thread_join arguments, then frees a fake zombie thread
+ * linked under the current process as its halt would, and a live one whose slot runs a
+ * program it started with execute
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: thread_create, thread_join, group_leader, thread_group_kill, exec_chain_kill
+ * Files: thread.c/h
+ */
+int thread_test(){
+	TEST_HEADER;
+	static pcb_struct thread;
+	pcb_struct* pcb = current_pcb();
+	pcb_struct* saved = pcb->next_thread;
+	pcb_struct* child;
+	int32_t count, pid;
+	int result = PASS;
+
+	if(thread_create(0, 0, ONE_THIRTY_TWO_MB) != -1) result = FAIL;				// entry outside the page
+	if(thread_create(EXECUTE_ADDR, 0, MB_128 + 4) != -1) result = FAIL;			// no room for the frame
+	pcb->next_thread = NULL;
+	if(thread_join(pcb->pid, NULL) != -1) result = FAIL;						// not a thread
+
+	memset(&thread, 0, sizeof(thread));
+	thread.pid = 5;
+	thread.active = 1;
+	thread.zombie = 1;
+	thread.group_leader = pcb;
+	pcb->next_thread = &thread;
+	if(group_leader(&thread) != pcb || group_leader(pcb) != pcb) result = FAIL;
+	cli();
+	thread_group_kill(pcb);
+	sti();
+	if(pcb->next_thread != NULL || thread.active != 0) result = FAIL;
+
+	for(pid = PROCESS_NUMBER_PIT; pid < MAX_PCB; pid++){						// a free pid for the child
+		child = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1));
+		if(!child->active) break;
+	}
+	if(pid == MAX_PCB){
+		pcb->next_thread = saved;
+		return FAIL;
+	}
+	memset(child, 0, sizeof(pcb_struct));
+	memset(&thread, 0, sizeof(thread));
+	thread.pid = MAX_TASKS;													// not a real pid
+	thread.active = 1;
+	thread.group_leader = pcb;
+	thread.slot = alloc_background_slot();
+	child->pid = pid;
+	child->active = 1;
+	child->parent_id = thread.pid;
+	child->slot = thread.slot;
+	schedule_array[thread.slot] = child->pid;						// the thread waits in execute
+	pcb->next_thread = &thread;
+	count = process_count;
+	cli();
+	thread_group_kill(pcb);
+	sti();
+	if(schedule_array[thread.slot] != SLOT_FREE || child->active != 0 || thread.active != 0) result = FAIL;
+	process_count = count;
+
+	pcb->next_thread = saved;
+	return result;
+}
+
+/* fpu Test
+ * 
+ * Touches the FPU with TS set, the #NM handler must make the current process the owner
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: fpu_trap, fpu_switch, fpu_release
+ * Files: fpu.c/h
+ */
+int fpu_test(){
+	TEST_HEADER;
+	pcb_struct* pcb = current_pcb();
+	int result = PASS;
+
+	if(!fpu_enabled) return PASS;			// no FXSAVE, nothing to switch
+	fpu_release(pcb);
+	fpu_switch(pcb);						// not the owner, TS set
+	asm volatile ("fldz; fstp %%st(0)" : : : "memory");
+	if(fpu_owner != pcb || !pcb->fpu_used) result = FAIL;
+	fpu_release(pcb);
+	if(fpu_owner != NULL || pcb->fpu_used) result = FAIL;
+	fpu_switch(pcb);
+	return result;
+}
+
+static uint8_t simd_src[2048], simd_dst[2048];		// too big for the kernel stack
+
+/* lib_simd Test
+ * 
+ * Checks the word-at-a-time string routines and the SSE2 memcpy/memset/memmove against
+ * byte loops, over every source and destination offset within a word and sizes on both
+ * sides of the SSE2 cutoff
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: strlen, strnlen, strncmp, strncpy, memcpy, memset, memmove
+ * Files: lib.c/h
+ */
+int lib_simd_test(){
+	TEST_HEADER;
+	uint32_t sizes[] = {0, 1, 3, 64, 511, 512, 1000, 1500};
+	uint32_t s, i, d, o, n;
+	uint32_t cr0, cr0_after;
+
+	for(i = 0; i < sizeof(simd_src); i++) simd_src[i] = i * 7 + 1;
+	asm volatile ("movl %%cr0, %0" : "=r"(cr0));
+	for(s = 0; s < sizeof(sizes) / sizeof(sizes[0]); s++){
+		n = sizes[s];
+		for(d = 0; d < 4; d++){
+			for(o = 0; o < 4; o++){
+				memset(simd_dst, 0xAA, sizeof(simd_dst));
+				memcpy(simd_dst + d, simd_src + o, n);
+				for(i = 0; i < n; i++)
+					if(simd_dst[d + i] != simd_src[o + i]) return FAIL;
+				if(simd_dst[d + n] != 0xAA) return FAIL;
+
+				memset(simd_dst + d, o, n);
+				for(i = 0; i < n; i++)
+					if(simd_dst[d + i] != o) return FAIL;
+				if(simd_dst[d + n] != 0xAA) return FAIL;
+
+				memcpy(simd_dst, simd_src, sizeof(simd_dst));
+				memmove(simd_dst + d + 5, simd_dst + o, n);	// overlapping, dest above src
+				for(i = 0; i < n; i++)
+					if(simd_dst[d + 5 + i] != simd_src[o + i]) return FAIL;
+			}
+		}
+	}
+	asm volatile ("movl %%cr0, %0" : "=r"(cr0_after));
+	if((cr0 ^ cr0_after) & CR0_TS) return FAIL;		// kernel_fpu_end puts TS back
+
+	for(o = 0; o < 4; o++){
+		strncpy((int8_t*)simd_dst + o, "word at a time", 20);
+		if(strlen((int8_t*)simd_dst + o) != 14) return FAIL;
+		if(strnlen((int8_t*)simd_dst + o, 6) != 6) return FAIL;
+		if(simd_dst[o + 19] != '\0') return FAIL;
+		if(strncmp((int8_t*)simd_dst + o, "word at a time", 20) != 0) return FAIL;
+		if(strncmp((int8_t*)simd_dst + o, "word at a tile", 20) <= 0) return FAIL;
+		if(strncmp((int8_t*)simd_dst + o, "word at a tile", 12) != 0) return FAIL;
+		if(strncmp((int8_t*)simd_dst + o, "word", 20) <= 0) return FAIL;
+	}
+	return PASS;
+}
+
+/* snprintf Test
+ * 
+ * Checks snprintf conversions, field widths and truncation
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: snprintf
+ * Files: lib.c/h
+ */
+int snprintf_test(){
+	TEST_HEADER;
+	int8_t buf[40];
+	int8_t small[5];
+
+	if(snprintf(buf, sizeof(buf), "%d %u %x %#x %c %s %%", -7, 12, 255, 14, 'q', "hi") != 24) return FAIL;
+	if(strncmp(buf, "-7 12 FF 0000000E q hi %", sizeof(buf)) != 0) return FAIL;
+	snprintf(buf, sizeof(buf), "%5d|%-5d|%05d|%4s", 42, 42, -42, "ab");
+	if(strncmp(buf, "   42|42   |-0042|  ab", sizeof(buf)) != 0) return FAIL;
+	if(snprintf(small, sizeof(small), "%s", "truncated") != 9) return FAIL;	// length it wanted
+	if(strncmp(small, "trun", sizeof(small)) != 0) return FAIL;
+	if(snprintf(NULL, 0, "%d", 1000) != 4) return FAIL;
+	return PASS;
+}
+
+/* prof Test
+ * 
+ * Checks the rates profile() takes, then feeds prof_tick a kernel frame and finds its eip
+ * and the return address of this function in the "profile" file
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Leaves one sample in the profiler, which is stopped again
+ * Coverage: profile, prof_tick, prof_read
+ * Files: prof.c/h
+ */
+int prof_test(){
+	TEST_HEADER;
+	uint8_t name[FNAME_LENGTH] = "profile";
+	static uint8_t buf[PROF_LINE_LEN * 4];
+	int8_t expect[PROF_LINE_LEN];
+	hw_context_t regs;
+	uint32_t flags, ebp;
+	int32_t fd, count, len, i;
+	int32_t found = 0;
+
+	test_fixture_pcb();
+
+	if(profile(3) != -1 || profile(2048) != -1 || profile(-1) != -1) return FAIL;
+	asm volatile ("movl %%ebp, %0" : "=r"(ebp));
+	memset(&regs, 0, sizeof(regs));
+	regs.eip = (uint32_t)prof_test;
+	regs.cs = KERNEL_CS;
+	regs.ebp = ebp;
+	cli_and_save(flags);
+	profile(MAX_FREQUENCY);				// a sample every tick
+	prof_tick(&regs);
+	profile(0);
+	restore_flags(flags);
+
+	len = snprintf(expect, sizeof(expect), " k %x %x", (uint32_t)prof_test, ((uint32_t*)ebp)[1]);
+	fd = open(name);
+	if(fd == -1) return FAIL;
+	count = read(fd, buf, sizeof(buf));
+	for(i = 0; i + len <= count; i++){
+		if(!strncmp((int8_t*)&buf[i], expect, len)) found++;
+	}
+	if(read(fd, buf, sizeof(buf)) != 0) found = 0;	// the one sample was read the first time
+	close(fd);
+	return (found == 1) ? PASS : FAIL;
+}
+
+#define SYSSTAT_TEST_NR	3		// read in syscall_jump_table
+
+/* sysstat Test
+ * 
+ * Times one fake read through sysstat_enter/sysstat_exit and finds it in the "syscalls"
+ * file and in the counters of the current process
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: Clears the system wide system call table
+ * Coverage: sysstat_enter, sysstat_exit, sysstat_read
+ * Files: sysstat.c/h
+ */
+int sysstat_test(){
+	TEST_HEADER;
+	uint8_t name[FNAME_LENGTH] = "syscalls";
+	static uint8_t buf[2048];
+	int8_t expect[32];
+	uint32_t before;
+	uint64_t start;
+	int32_t fd, count, len, i;
+	int32_t found = 0;
+
+	test_fixture_pcb();
+
+	fd = open(name);
+	if(fd == -1) return FAIL;
+	if(write(fd, buf, 1) != 1) return FAIL;			// clear
+	before = group_leader(current_pcb())->sys_calls[SYSSTAT_TEST_NR];
+	start = sysstat_enter(SYSSTAT_TEST_NR);
+	sysstat_exit(start, SYSSTAT_TEST_NR);
+	if(group_leader(current_pcb())->sys_calls[SYSSTAT_TEST_NR] != before + 1) return FAIL;
+
+	len = snprintf(expect, sizeof(expect), "%-14s %8u ", "read", 1);
+	count = read(fd, buf, sizeof(buf));
+	for(i = 0; i + len <= count; i++){
+		if(!strncmp((int8_t*)&buf[i], expect, len)) found++;
+	}
+	if(read(fd, buf, sizeof(buf)) != 0) found = 0;	// everything was read the first time
+	close(fd);
+	return (found == 1) ? PASS : FAIL;
+}
+
+/* procfs Test
+ * 
+ * Asserts that the synthetic files have their own dentry type, that "ps" lists the kworker
+ * thread and ends, and that reading "meminfo" in small pieces gives the same text as one read
+ * Inputs: None
+ * Outputs: PASS/FAIL
+ * Side Effects: None
+ * Coverage: procfs_dentry_by_name, procfs_read
+ * Files: procfs.c
+ */
+int procfs_test(){
+	TEST_HEADER;
+	uint8_t ps[FNAME_LENGTH] = "ps";
+	uint8_t meminfo[FNAME_LENGTH] = "meminfo";
+	static uint8_t whole[1024];
+	static uint8_t pieces[1024];
+	int8_t expect[64];
+	dentry_t dentry;
+	int32_t fd, count, total, len, i;
+	int32_t found = 0;
+
+	test_fixture_pcb();
+
+	if(procfs_dentry_by_name(ps, &dentry) == -1 || dentry.file_type != PROC_FILE_TYPE) return FAIL;
+	if(read_dentry_by_name(ps, &dentry) != -1) return FAIL;		// not in the image
+
+	fd = open(ps);
+	if(fd == -1) return FAIL;
+	if(write(fd, whole, 1) != -1) return FAIL;					// read-only
+	count = read(fd, whole, sizeof(whole));
+	len = snprintf(expect, sizeof(expect), "%5d %5d", schedule_array[KTHREAD_SLOT_BASE], -1);	// tests run before any process
+	for(i = 0; i + len <= count; i++){
+		if(!strncmp((int8_t*)&whole[i], expect, len)) found++;
+	}
+	if(read(fd, whole, sizeof(whole)) != 0) found = 0;			// everything was read the first time
+	close(fd);
+	if(found != 1) return FAIL;
+
+	fd = open(meminfo);
+	if(fd == -1) return FAIL;
+	count = read(fd, whole, sizeof(whole));
+	close(fd);
+	fd = open(meminfo);
+	total = 0;
+	while((len = read(fd, &pieces[total], 7)) > 0){
+		total += len;
+	}
+	close(fd);
+	if(count <= 0 || total != count) return FAIL;
+	return strncmp((int8_t*)whole, (int8_t*)pieces, count) ? FAIL : PASS;
+}
 
 /* Test suite entry point */
 void launch_tests(){
@@ -1132,5 +1961,28 @@ void launch_tests(){
 	// TEST_OUTPUT("system_regular_dir_test", system_regular_dir_test());
 	// TEST_OUTPUT("system_rtc_test", system_rtc_test());
 	// TEST_OUTPUT("system_rtc_test", system_rtc_test());
+
+	// Checkpoint 5 tests
+	// TEST_OUTPUT("klog_test", klog_test());
+	// TEST_OUTPUT("rtc_wheel_test", rtc_wheel_test());
+	// TEST_OUTPUT("clock_test", clock_test());
+	// TEST_OUTPUT("vdso_test", vdso_test());
+	// TEST_OUTPUT("timer_sleep_test", timer_sleep_test());
+	// TEST_OUTPUT("sysenter_test", sysenter_test());
+	// TEST_OUTPUT("uring_test", uring_test());
+	// TEST_OUTPUT("pipe_test", pipe_test());
+	// TEST_OUTPUT("shm_test", shm_test());
+	// TEST_OUTPUT("futex_test", futex_test());
+	// TEST_OUTPUT("poll_test", poll_test());
+	// TEST_OUTPUT("signal_test", signal_test());
+	// TEST_OUTPUT("waitpid_test", waitpid_test());
+	// TEST_OUTPUT("kthread_test", kthread_test());
+	// TEST_OUTPUT("thread_test", thread_test());
+	// TEST_OUTPUT("fpu_test", fpu_test());
+	// TEST_OUTPUT("lib_simd_test", lib_simd_test());
+	// TEST_OUTPUT("snprintf_test", snprintf_test());
+	// TEST_OUTPUT("prof_test", prof_test());
+	// TEST_OUTPUT("sysstat_test", sysstat_test());
+	// TEST_OUTPUT("procfs_test", procfs_test());
 }
 
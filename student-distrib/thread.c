@@ -0,0 +1,242 @@
+/* thread.c: threads of a user program
+ * A thread is a task with its own PCB, kernel stack and user stack that shares the program
+ * page, shared segments and file descriptors of its group leader, the process that runs the
+ * program. It runs from a background slot like a spawned process, the scheduler maps the
+ * leader's page and segments for it, and descriptor lookups go through files_pcb. A thread
+ * ends with thread_exit, by returning from its function, or on halt or a fault, and stays a
+ * zombie until another task of the group collects it with thread_join. Threads still in the
+ * group when the leader halts are taken down with it, together with any program a thread
+ * started with execute, which runs in the thread's slot.
+ */
+
+#include "thread.h"
+#include "lib.h"
+#include "system_call.h"
+#include "scheduling.h"
+#include "timer.h"
+#include "idt_number.h"
+#include "fpu.h"
+#include "shm.h"
+
+/* movl %eax, %ebx; movl $THREAD_EXIT_NUM, %eax; int $0x80; nop; nop; nop */
+static const uint8_t thread_exit_code[THREAD_TRAMPOLINE_LEN] = {
+    0x89, 0xC3, 0xB8, THREAD_EXIT_NUM, 0x00, 0x00, 0x00, 0xCD, 0x80, 0x90, 0x90, 0x90
+};
+
+/* pcb_struct* group_leader(pcb_struct* pcb)
+ * inputs: pcb -- process or thread
+ * outputs: the process whose page and descriptors pcb uses, pcb itself for a process
+ * Function: finds the group leader
+ */
+pcb_struct* group_leader(pcb_struct* pcb){
+    return (pcb->group_leader != NULL) ? pcb->group_leader : pcb;
+}
+
+static pcb_struct* files_override = NULL;   // set while exec_chain_kill closes another task's files
+
+/* pcb_struct* files_pcb(void)
+ * inputs: none
+ * outputs: the PCB that holds the descriptors of the running task
+ * Function: the running process, or the leader when a thread is running
+ */
+pcb_struct* files_pcb(void){
+    if(files_override != NULL){
+        return files_override;
+    }
+    return group_leader(current_pcb());
+}
+
+/* int32_t thread_create(uint32_t entry, uint32_t arg, uint32_t stack_top)
+ * Inputs: entry -- function in the user page the thread starts in, called with arg
+ *         arg -- argument of entry
+ *         stack_top -- end of the memory the caller set aside for the thread's stack
+ * Return Value: thread id (a pid), -1 on a bad address or when no PCB or slot is free
+ *  Function: system call, starts a thread in the caller's program. A small trampoline at
+ *            the top of the new stack turns a return from entry into thread_exit. */
+int32_t thread_create(uint32_t entry, uint32_t arg, uint32_t stack_top){
+    pcb_struct* caller = current_pcb();
+    pcb_struct* leader = group_leader(caller);
+    pcb_struct* pcb;
+    uint32_t* sp;
+    uint32_t tramp;
+    int32_t pid, slot;
+
+    stack_top &= ~(sizeof(uint32_t) - 1);
+    if(!user_buffer_ok((void*)entry, 1) || stack_top < THREAD_FRAME_SIZE ||
+       !user_buffer_ok((void*)(stack_top - THREAD_FRAME_SIZE), THREAD_FRAME_SIZE)){
+        return FAIL_NEG_ONE;
+    }
+    cli();
+    slot = alloc_background_slot();
+    if(slot == -1){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+    for(pid = 0; pid < MAX_PCB; pid++){
+        if(!((pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1)))->active){
+            break;
+        }
+    }
+    if(pid == MAX_PCB){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+
+    // exit trampoline, then the argument and a return address into the trampoline
+    tramp = stack_top - THREAD_TRAMPOLINE_LEN;
+    memcpy((void*)tramp, thread_exit_code, THREAD_TRAMPOLINE_LEN);
+    sp = (uint32_t*)tramp;
+    *--sp = arg;
+    *--sp = tramp;
+
+    pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1));
+    memset(pcb, 0, sizeof(pcb_struct));
+    fpu_release(pcb);
+    pcb->pid = pid;
+    pcb->parent_id = caller->pid;
+    pcb->active = 1;
+    pcb->entry_point = entry;
+    pcb->user_esp = (uint32_t)sp;
+    pcb->terminal_num = caller->terminal_num;
+    pcb->state = PROC_RUNNABLE;
+    pcb->slot = slot;
+    pcb->fresh = 1;
+    memcpy(pcb->sig_handler, caller->sig_handler, sizeof(pcb->sig_handler));
+    memcpy(pcb->args, caller->args, ARGS_LEN);
+    memcpy(pcb->name, caller->name, sizeof(pcb->name));
+    pcb->group_leader = leader;
+    pcb->next_thread = leader->next_thread;
+    leader->next_thread = pcb;
+    schedule_array[slot] = pid;     // runnable from the next PIT tick
+    sti();
+    return pid;
+}
+
+/* int32_t thread_join(int32_t tid, int32_t* status)
+ * Inputs: tid -- thread of the caller's group
+ *         status -- where to store its exit status in the user page, may be NULL
+ * Return Value: 0 once the thread has ended, -1 if tid is not another thread of the group,
+ *               status is a bad pointer, another task is joining it already or a signal
+ *               arrived first
+ *  Function: system call, waits for a thread to end and frees it */
+int32_t thread_join(int32_t tid, int32_t* status){
+    pcb_struct* caller = current_pcb();
+    pcb_struct* leader = group_leader(caller);
+    pcb_struct** link;
+    pcb_struct* pcb;
+
+    if(status != NULL && !user_buffer_ok(status, sizeof(int32_t))){
+        return FAIL_NEG_ONE;
+    }
+    cli();
+    for(link = &leader->next_thread; *link != NULL && (*link)->pid != tid; link = &(*link)->next_thread);
+    pcb = *link;
+    if(pcb == NULL || pcb == caller || (pcb->joiner != NULL && pcb->joiner != caller)){
+        sti();
+        return FAIL_NEG_ONE;
+    }
+    pcb->joiner = caller;
+    while(!pcb->zombie){
+        if(block_current(TIMER_NO_DEADLINE) == -1){
+            pcb->joiner = NULL;
+            sti();
+            return FAIL_NEG_ONE;
+        }
+    }
+    // threads created while we slept sit in front of it, find its link again
+    for(link = &leader->next_thread; *link != pcb; link = &(*link)->next_thread);
+    *link = pcb->next_thread;
+    if(status != NULL){
+        *status = pcb->exit_status;
+    }
+    pcb->zombie = 0;
+    pcb->active = 0;
+    sti();
+    return 0;
+}
+
+/* int32_t thread_exit(int32_t status)
+ * Inputs: status -- exit status for thread_join
+ * Return Value: does not return
+ *  Function: system call, ends the running thread and wakes the task joining it. Like
+ *            halt_spawned it frees the slot and switches to the next task through schedule_exit.
+ *            From the group leader it halts the program instead. */
+int32_t thread_exit(int32_t status){
+    pcb_struct* pcb = current_pcb();
+
+    if(pcb->group_leader == NULL){
+        return system_halt((uint8_t)status);
+    }
+    cli();
+    release_children(pcb);
+    fpu_release(pcb);
+    if(schedule_array[pcb->slot] == pcb->pid){
+        schedule_array[pcb->slot] = SLOT_FREE;
+    }
+    pcb->exit_status = status;
+    pcb->zombie = 1;
+    if(pcb->joiner != NULL){
+        wake_process(pcb->joiner);
+    }
+    schedule_exit();
+    return 0;
+}
+
+/* static void exec_chain_kill(pcb_struct* thread)
+ * inputs: thread -- thread about to be freed
+ * outputs: none
+ * Function: a thread that called execute waits in it while the child runs in its slot, and
+ *           the child may have run execute in turn. Frees those programs, the innermost
+ *           first, as their halt would but without returning to the thread. Called with
+ *           interrupts disabled.
+ */
+static void exec_chain_kill(pcb_struct* thread){
+    pcb_struct* pcb;
+    int32_t fd;
+
+    while(schedule_array[thread->slot] != thread->pid){
+        pcb = (pcb_struct*)(EIGHT_MB - EIGHT_KB*(schedule_array[thread->slot]+1));
+        thread_group_kill(pcb);
+        timer_forget(pcb);
+        files_override = pcb;           // close and shm_detach work on files_pcb
+        for(fd = 0; fd <= FD_MAX; fd++){
+            if(pcb->file_descriptor[fd].flags == 1){
+                pcb->file_descriptor[fd].file_operations_table_pointer->close(fd);
+            }
+        }
+        shm_detach_all(pcb);
+        files_override = NULL;
+        release_children(pcb);
+        fpu_release(pcb);
+        process_count--;
+        if(pcb->is_shell == 1){
+            shell_process_count--;
+        }
+        schedule_array[thread->slot] = pcb->parent_id;
+        pcb->active = 0;
+    }
+}
+
+/* void thread_group_kill(pcb_struct* leader)
+ * inputs: leader -- halting process, the one running
+ * outputs: none
+ * Function: frees every thread of the process, running or not, with the programs a thread
+ *           started with execute. None of them runs again, so they are taken off the timer
+ *           and wait queues they sleep on. Called with interrupts disabled.
+ */
+void thread_group_kill(pcb_struct* leader){
+    pcb_struct* pcb;
+
+    for(pcb = leader->next_thread; pcb != NULL; pcb = pcb->next_thread){
+        if(!pcb->zombie){
+            exec_chain_kill(pcb);
+            timer_forget(pcb);
+            release_children(pcb);
+            fpu_release(pcb);
+            schedule_array[pcb->slot] = SLOT_FREE;
+        }
+        pcb->zombie = 0;
+        pcb->active = 0;
+    }
+    leader->next_thread = NULL;
+}
@@ -0,0 +1,21 @@
+/* thread.h: threads sharing the program page and descriptors of a process */
+
+#ifndef _THREAD_H
+#define _THREAD_H
+
+#include "types.h"
+#include "filesys.h"
+
+#define THREAD_TRAMPOLINE_LEN   12      // exit code copied to the top of a thread's stack
+#define THREAD_FRAME_SIZE       (THREAD_TRAMPOLINE_LEN + 2 * sizeof(uint32_t))   // plus arg and return address
+
+pcb_struct* group_leader(pcb_struct* pcb);
+pcb_struct* files_pcb(void);
+void thread_group_kill(pcb_struct* leader);
+
+/* system calls */
+int32_t thread_create(uint32_t entry, uint32_t arg, uint32_t stack_top);
+int32_t thread_join(int32_t tid, int32_t* status);
+int32_t thread_exit(int32_t status);
+
+#endif /* _THREAD_H */
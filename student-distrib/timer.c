@@ -0,0 +1,229 @@
+/* timer.c: sorted timer queue, sleeping, timed waits and wait queues for processes
+ * A process that blocks is marked PROC_BLOCKED and halts the CPU until an interrupt instead of
+ * polling, and the scheduler passes over it while another process can run. If it blocked with
+ * a deadline it sits on a queue sorted by deadline. The timer softirq runs on every PIT tick
+ * and wakes the processes whose deadline has passed, so a sleep ends within one tick of it.
+ * A wait queue collects the processes waiting for the same event, such as data in a pipe.
+ * A signal for a blocked process wakes it too, and the system call it sleeps in returns -1.
+ */
+
+#include "timer.h"
+#include "lib.h"
+#include "softirq.h"
+#include "system_call.h"
+#include "scheduling.h"
+#include "signal.h"
+
+static pcb_struct* timer_queue = NULL;     // earliest deadline first
+
+void timer_softirq(void);
+
+/* void timer_init(void);
+ * Inputs: none
+ * Return Value: none
+ *  Function: empties the timer queue and hooks it on the timer softirq */
+void timer_init(void){
+    timer_queue = NULL;
+    open_softirq(SOFTIRQ_TIMER, timer_softirq);
+}
+
+/* pcb_struct* current_pcb(void);
+ * Inputs: none
+ * Return Value: PCB of the running process, which may be a background process that is not
+ *               in front of its terminal. Before the first shell starts this is pid 0.
+ *  Function: helper for code that acts on the caller of a system call */
+pcb_struct* current_pcb(void){
+    int32_t pid = (process_num < 0) ? 0 : process_num;
+    return (pcb_struct*)(EIGHT_MB - EIGHT_KB*(pid+1));
+}
+
+/* void timer_add(pcb_struct* pcb);
+ * Inputs: pcb_struct* pcb -- process with wake_time set
+ * Return Value: none
+ *  Function: inserts in deadline order, called with interrupts disabled */
+static void timer_add(pcb_struct* pcb){
+    pcb_struct** link = &timer_queue;
+    while(*link != NULL && (*link)->wake_time <= pcb->wake_time){
+        link = &(*link)->timer_next;
+    }
+    pcb->timer_next = *link;
+    *link = pcb;
+    pcb->on_timer_queue = 1;
+}
+
+/* void timer_del(pcb_struct* pcb);
+ * Inputs: pcb_struct* pcb -- process, may be off the queue
+ * Return Value: none
+ *  Function: removes a process from the queue, called with interrupts disabled */
+static void timer_del(pcb_struct* pcb){
+    pcb_struct** link = &timer_queue;
+    if(!pcb->on_timer_queue){
+        return;
+    }
+    while(*link != NULL){
+        if(*link == pcb){
+            *link = pcb->timer_next;
+            break;
+        }
+        link = &(*link)->timer_next;
+    }
+    pcb->timer_next = NULL;
+    pcb->on_timer_queue = 0;
+}
+
+/* void timer_softirq(void);
+ * Inputs: none
+ * Return Value: none
+ *  Function: timer softirq, wakes every process whose deadline has passed. Only the head of
+ *            the queue is looked at when nothing is due. Also drives SIG_ALARM. */
+void timer_softirq(void){
+    uint32_t flags;
+    uint64_t now = clock_ns();
+    pcb_struct* pcb;
+
+    cli_and_save(flags);
+    while(timer_queue != NULL && timer_queue->wake_time <= now){
+        pcb = timer_queue;
+        timer_queue = pcb->timer_next;
+        pcb->timer_next = NULL;
+        pcb->on_timer_queue = 0;
+        pcb->timed_out = 1;
+        pcb->state = PROC_RUNNABLE;
+    }
+    restore_flags(flags);
+    signal_alarm_tick();
+}
+
+/* void wake_process(pcb_struct* pcb);
+ * Inputs: pcb_struct* pcb -- blocked process
+ * Return Value: none
+ *  Function: ends a block_current before its deadline, safe from interrupt context */
+void wake_process(pcb_struct* pcb){
+    uint32_t flags;
+    cli_and_save(flags);
+    if(pcb->state == PROC_BLOCKED){
+        timer_del(pcb);
+        pcb->timed_out = 0;
+        pcb->state = PROC_RUNNABLE;
+    }
+    restore_flags(flags);
+}
+
+/* int32_t block_current(uint64_t deadline);
+ * Inputs: uint64_t deadline -- clock_ns time to give up at, TIMER_NO_DEADLINE to wait for
+ *                              wake_process only
+ * Return Value: 0 if woken by wake_process, -1 if the deadline passed or a signal woke it
+ *  Function: blocks the calling process. The caller checks its wake condition with interrupts
+ *            disabled before calling so a wake_process from an interrupt cannot be missed.
+ *            A pending signal (see signal_pending) returns -1 at once without blocking. A
+ *            signal that comes after a normal wake is left for the caller's return to user
+ *            mode and does not change the result.
+ *            Returns with interrupts disabled. */
+int32_t block_current(uint64_t deadline){
+    pcb_struct* pcb = current_pcb();
+
+    cli();
+    if(signal_pending(pcb)){
+        return -1;
+    }
+    pcb->timed_out = 0;
+    pcb->sig_woken = 0;
+    pcb->state = PROC_BLOCKED;
+    if(deadline != TIMER_NO_DEADLINE){
+        pcb->wake_time = deadline;
+        timer_add(pcb);
+    }
+    while(pcb->state == PROC_BLOCKED){
+        asm volatile ("sti; hlt; cli" : : : "memory");     // sti delays interrupts until after hlt
+    }
+    return (pcb->timed_out || pcb->sig_woken) ? -1 : 0;
+}
+
+/* int32_t nanosleep(const timespec_t* req);
+ * Inputs: const timespec_t* req -- how long to sleep
+ * Return Value: 0 after the time has passed, -1 for a bad pointer or nanosecond count or if
+ *               a signal ended the sleep early
+ *  Function: system call, blocks the caller until at least req has passed */
+int32_t nanosleep(const timespec_t* req){
+    uint64_t deadline;
+
+    if((uint32_t)req < MB_128 || (uint32_t)req > ONE_THIRTY_TWO_MB - sizeof(timespec_t)){
+        return FAIL_NEG_ONE;
+    }
+    if(req->tv_nsec >= NS_PER_SEC){
+        return FAIL_NEG_ONE;
+    }
+    deadline = clock_ns() + (uint64_t)req->tv_sec * NS_PER_SEC + req->tv_nsec;
+    if(deadline == TIMER_NO_DEADLINE){
+        deadline = 1;
+    }
+    block_current(deadline);
+    sti();
+    return (clock_ns() < deadline) ? FAIL_NEG_ONE : 0;     // only a signal ends it early
+}
+
+/* static void wait_queue_del(pcb_struct* pcb);
+ * Inputs: pcb_struct* pcb -- process, may be on no queue
+ * Return Value: none
+ *  Function: unlinks a process from the queue it waits on, called with interrupts disabled */
+static void wait_queue_del(pcb_struct* pcb){
+    pcb_struct** link;
+    if(pcb->wait_queue == NULL){
+        return;
+    }
+    link = &pcb->wait_queue->head;
+    while(*link != NULL){
+        if(*link == pcb){
+            *link = pcb->wait_next;
+            break;
+        }
+        link = &(*link)->wait_next;
+    }
+    pcb->wait_next = NULL;
+    pcb->wait_queue = NULL;
+}
+
+/* int32_t wait_event(wait_queue_t* wq, uint64_t deadline);
+ * Inputs: wait_queue_t* wq -- queue to sleep on
+ *         uint64_t deadline -- as for block_current
+ * Return Value: 0 if woken by wake_up, -1 if the deadline passed or a signal woke it
+ *  Function: blocks the caller on wq. Like block_current, the caller tests its condition with
+ *            interrupts disabled, and tests it again after waking. Returns with interrupts
+ *            disabled. */
+int32_t wait_event(wait_queue_t* wq, uint64_t deadline){
+    pcb_struct* pcb = current_pcb();
+    int32_t ret;
+
+    cli();
+    pcb->wait_next = wq->head;
+    pcb->wait_queue = wq;
+    wq->head = pcb;
+    ret = block_current(deadline);
+    wait_queue_del(pcb);
+    return ret;
+}
+
+/* void timer_forget(pcb_struct* pcb);
+ * Inputs: pcb_struct* pcb -- task that will never run again
+ * Return Value: none
+ *  Function: takes it off the timer queue and the wait queue it sleeps on, called with
+ *            interrupts disabled */
+void timer_forget(pcb_struct* pcb){
+    timer_del(pcb);
+    wait_queue_del(pcb);
+}
+
+/* void wake_up(wait_queue_t* wq);
+ * Inputs: wait_queue_t* wq -- queue to wake
+ * Return Value: none
+ *  Function: wakes every process on wq, they take themselves off when they run */
+void wake_up(wait_queue_t* wq){
+    uint32_t flags;
+    pcb_struct* pcb;
+
+    cli_and_save(flags);
+    for(pcb = wq->head; pcb != NULL; pcb = pcb->wait_next){
+        wake_process(pcb);
+    }
+    restore_flags(flags);
+}
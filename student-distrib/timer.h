@@ -0,0 +1,26 @@
+/* timer.h: sorted timer queue, sleeping, timed waits and wait queues for processes */
+
+#ifndef _TIMER_H
+#define _TIMER_H
+
+#include "types.h"
+#include "filesys.h"
+#include "clock.h"
+
+#define TIMER_NO_DEADLINE   0
+
+/* processes sleeping until some event, linked through pcb->wait_next */
+typedef struct wait_queue_t {
+    pcb_struct* head;
+} wait_queue_t;
+
+void timer_init(void);
+int32_t block_current(uint64_t deadline);
+void wake_process(pcb_struct* pcb);
+pcb_struct* current_pcb(void);
+int32_t nanosleep(const timespec_t* req);
+int32_t wait_event(wait_queue_t* wq, uint64_t deadline);
+void wake_up(wait_queue_t* wq);
+void timer_forget(pcb_struct* pcb);
+
+#endif /* _TIMER_H */
@@ -0,0 +1,87 @@
+/* uring.c: shared submission/completion rings for batched system calls
+ * A program registers a uring_t in its own page with uring_setup, queues read, write, open
+ * and close requests in the submission ring, and has the kernel run a whole batch with one
+ * uring_enter instead of one trap per request. Every request is run to completion through
+ * the ordinary system call function and its return value lands in the completion ring.
+ */
+
+#include "uring.h"
+#include "lib.h"
+#include "system_call.h"
+#include "timer.h"
+
+/* int32_t uring_setup(uring_t* ring);
+ * Inputs: uring_t* ring -- rings in the program's page, NULL to unregister
+ * Return Value: 0 on success, -1 if the rings are not in the user page
+ *  Function: system call, registers the rings of the calling process and empties them */
+int32_t uring_setup(uring_t* ring){
+    pcb_struct* pcb = current_pcb();
+
+    if(ring == NULL){
+        pcb->uring = NULL;
+        return 0;
+    }
+    if(!user_buffer_ok(ring, sizeof(uring_t))){
+        return FAIL_NEG_ONE;
+    }
+    ring->sq_head = 0;
+    ring->sq_tail = 0;
+    ring->cq_head = 0;
+    ring->cq_tail = 0;
+    pcb->uring = ring;
+    return 0;
+}
+
+/* static int32_t uring_run(const uring_sqe_t* sqe);
+ * Inputs: const uring_sqe_t* sqe -- kernel copy of a submission
+ * Return Value: the result of the request, -1 for an unknown opcode
+ *  Function: runs one request with the same checks as its system call */
+static int32_t uring_run(const uring_sqe_t* sqe){
+    switch(sqe->opcode){
+    case URING_OP_NOP:
+        return 0;
+    case URING_OP_READ:
+        return read(sqe->fd, (void*)sqe->addr, sqe->len);
+    case URING_OP_WRITE:
+        return write(sqe->fd, (const void*)sqe->addr, sqe->len);
+    case URING_OP_OPEN:
+        return open((const uint8_t*)sqe->addr);
+    case URING_OP_CLOSE:
+        return close(sqe->fd);
+    default:
+        return FAIL_NEG_ONE;
+    }
+}
+
+/* int32_t uring_enter(uint32_t to_submit);
+ * Inputs: uint32_t to_submit -- most submissions to consume
+ * Return Value: number of submissions consumed, -1 if no rings are registered
+ *  Function: system call, runs queued requests in order. It stops early when the submission
+ *            ring is empty or the completion ring is full, the program reaps and enters again */
+int32_t uring_enter(uint32_t to_submit){
+    pcb_struct* pcb = current_pcb();
+    uring_t* ring = pcb->uring;
+    uring_sqe_t sqe;
+    uring_cqe_t* cqe;
+    uint32_t done = 0;
+
+    if(ring == NULL){
+        return FAIL_NEG_ONE;
+    }
+    while(done < to_submit && ring->sq_head != ring->sq_tail){
+        if(ring->cq_tail - ring->cq_head >= URING_ENTRIES){
+            break;                          // no room for the completion
+        }
+        barrier();                          // read the entry after seeing the tail
+        sqe = ring->sqes[ring->sq_head & URING_MASK];
+        ring->sq_head++;
+
+        cqe = &ring->cqes[ring->cq_tail & URING_MASK];
+        cqe->user_data = sqe.user_data;
+        cqe->res = uring_run(&sqe);
+        barrier();                          // publish the entry before the tail
+        ring->cq_tail++;
+        done++;
+    }
+    return done;
+}
@@ -0,0 +1,47 @@
+/* uring.h: shared submission/completion rings for batched system calls */
+
+#ifndef _URING_H
+#define _URING_H
+
+#include "types.h"
+
+#define URING_ENTRIES   64                  // power of two, indexes wrap with URING_MASK
+#define URING_MASK      (URING_ENTRIES - 1)
+
+/* opcodes of a submission entry */
+#define URING_OP_NOP    0
+#define URING_OP_READ   1                   // read(fd, addr, len)
+#define URING_OP_WRITE  2                   // write(fd, addr, len)
+#define URING_OP_OPEN   3                   // open(addr)
+#define URING_OP_CLOSE  4                   // close(fd)
+
+typedef struct uring_sqe_t {
+    uint32_t opcode;
+    int32_t fd;
+    uint32_t addr;                          // user buffer or file name
+    int32_t len;
+    uint32_t user_data;                     // copied to the completion untouched
+} uring_sqe_t;
+
+typedef struct uring_cqe_t {
+    uint32_t user_data;
+    int32_t res;                            // what the system call returned
+} uring_cqe_t;
+
+/* Layout shared with syscalls/ece391uring.h. The ring lives in the program's own page.
+ * The program fills sqes[sq_tail & URING_MASK] and advances sq_tail, the kernel consumes
+ * from sq_head. The kernel fills cqes[cq_tail & URING_MASK], the program reaps from cq_head.
+ * Indexes only grow, so tail - head is the number of entries in a ring. */
+typedef struct uring_t {
+    volatile uint32_t sq_head;              // written by the kernel
+    volatile uint32_t sq_tail;              // written by the program
+    volatile uint32_t cq_head;              // written by the program
+    volatile uint32_t cq_tail;              // written by the kernel
+    uring_sqe_t sqes[URING_ENTRIES];
+    uring_cqe_t cqes[URING_ENTRIES];
+} uring_t;
+
+int32_t uring_setup(uring_t* ring);
+int32_t uring_enter(uint32_t to_submit);
+
+#endif /* _URING_H */
@@ -0,0 +1,79 @@
+/* vdso.c: read-only time page shared with every user program
+ * The page lives in the kernel image and is mapped user-readable at VDSO_ADDR through
+ * vidmap_page_table, so user programs read time without a system call. The PIT handler
+ * refreshes it every tick under a sequence counter.
+ */
+
+#include "vdso.h"
+#include "lib.h"
+#include "paging.h"
+#include "clock.h"
+
+extern volatile uint32_t rtc_jiffies;
+extern volatile uint32_t pit_ticks;
+
+static uint8_t vdso_page[FOUR_KB] __attribute__((aligned (FOUR_KB)));
+vdso_data_t* const vdso_data = (vdso_data_t*)vdso_page;
+
+/* void vdso_init(void)
+ * inputs: none
+ * outputs: none
+ * Function: fills the time page once the clock is calibrated and maps it at VDSO_ADDR
+ */
+void vdso_init(void){
+    pd_entry_pt vid_mem_pt;
+
+    memset(vdso_page, 0, FOUR_KB);
+    vdso_update();
+
+    vidmap_page_table[VDSO_PT_IDX] = vdso_pte();
+    vid_mem_pt.val             = 0;
+    vid_mem_pt.page_base_31_12 = ((uint32_t)vidmap_page_table/FOUR_KB);
+    vid_mem_pt.page_size       = 0; // 0 for page table page directory entry
+    vid_mem_pt.u_s             = 1; // user level
+    vid_mem_pt.r_w             = 1; // the page table entries decide, video memory is writable
+    vid_mem_pt.present         = 1; // PDE does exist
+    page_dir[VDSO_ADDR >> 22] = vid_mem_pt.val;
+    flush_tlb();
+}
+
+/* void vdso_update(void)
+ * inputs: none
+ * outputs: none
+ * Function: publishes the current ticks and time, called from the PIT handler
+ */
+void vdso_update(void){
+    uint32_t flags;
+    uint64_t now;
+
+    cli_and_save(flags);
+    now = rdtsc();
+    vdso_data->seq++;               // odd: readers retry
+    barrier();
+    vdso_data->pit_ticks = pit_ticks;
+    vdso_data->rtc_ticks = rtc_jiffies;
+    vdso_data->tsc_khz = tsc_khz;
+    vdso_data->clock_mult = clock_mult;
+    vdso_data->clock_shift = CLOCK_SHIFT;
+    vdso_data->tsc_base = tsc_base;
+    vdso_data->tick_tsc = now;
+    vdso_data->tick_ns = cycles_to_ns(now - tsc_base);
+    barrier();
+    vdso_data->seq++;               // even: consistent
+    restore_flags(flags);
+}
+
+/* uint32_t vdso_pte(void)
+ * inputs: none
+ * outputs: page table entry for VDSO_PT_IDX of vidmap_page_table
+ * Function: user, read-only mapping of the time page
+ */
+uint32_t vdso_pte(void){
+    pt_entry_page entry;
+    entry.val = 0;
+    entry.present = 1;
+    entry.r_w = 0;                  // user programs may only read it
+    entry.u_s = 1;
+    entry.page_base_31_12 = (uint32_t)vdso_page / FOUR_KB;
+    return entry.val;
+}
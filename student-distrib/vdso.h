@@ -0,0 +1,34 @@
+/* vdso.h: read-only time page shared with every user program */
+
+#ifndef _VDSO_H
+#define _VDSO_H
+
+#include "types.h"
+
+#define VDSO_PT_IDX     1                               // entry in vidmap_page_table, after video memory
+#define VDSO_ADDR       (0x8400000 + 4096 * VDSO_PT_IDX) // 132MB + 4KB in user space
+
+#define VDSO_FEAT_SYSENTER  0x1                         // SYSENTER/SYSEXIT system calls work
+
+/* Layout shared with syscalls/ece391vdso.h. seq is odd while the kernel writes, a reader
+ * retries until it sees the same even seq before and after copying. */
+typedef struct vdso_data_t {
+    volatile uint32_t seq;
+    uint32_t pit_ticks;             // PIT interrupts since boot
+    uint32_t rtc_ticks;             // 1024 Hz RTC ticks since boot
+    uint32_t tsc_khz;               // TSC calibration
+    uint32_t clock_mult;            // nanoseconds per cycle << clock_shift
+    uint32_t clock_shift;
+    uint64_t tsc_base;              // TSC at time zero
+    uint64_t tick_tsc;              // TSC at the last update
+    uint64_t tick_ns;               // monotonic time at the last update
+    uint32_t features;              // VDSO_FEAT_* bits, set once at boot
+} vdso_data_t;
+
+extern vdso_data_t* const vdso_data;
+
+void vdso_init(void);
+void vdso_update(void);
+uint32_t vdso_pte(void);
+
+#endif /* _VDSO_H */
@@ -0,0 +1,41 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * prof <hz>  starts the sampling profiler, "prof stop" stops it.  The
+ * samples stay in the kernel until the next start; "cat profile" on the
+ * serial terminal sends them to the host for prof_symbolize.py.
+ */
+
+#define BUFSIZE 128
+
+int main ()
+{
+    uint8_t buf[BUFSIZE];
+    uint32_t hz = 0;
+    uint8_t* p;
+
+    if (0 != ece391_getargs (buf, BUFSIZE)) {
+        ece391_fdputs (1, (uint8_t*)"usage: prof <hz> | prof stop\n");
+        return 3;
+    }
+    if (0 != ece391_strcmp (buf, (uint8_t*)"stop")) {
+        for (p = buf; *p >= '0' && *p <= '9'; p++)
+            hz = hz * 10 + (*p - '0');
+        if (p == buf || *p != '\0' || hz == 0) {
+            ece391_fdputs (1, (uint8_t*)"usage: prof <hz> | prof stop\n");
+            return 3;
+        }
+    }
+    if (0 != ece391_profile (hz)) {
+        ece391_fdputs (1, (uint8_t*)"rate must be a power of two up to 1024\n");
+        return 2;
+    }
+    if (hz == 0)
+        ece391_fdputs (1, (uint8_t*)"profiler stopped, samples are in \"profile\"\n");
+    else
+        ece391_fdputs (1, (uint8_t*)"profiler started\n");
+    return 0;
+}
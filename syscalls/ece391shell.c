@@ -4,14 +4,102 @@
 #include "ece391syscall.h"
 
 #define BUFSIZE 1024
+#define SAVED_FD 7	/* holds the terminal while fd 0 or 1 is a pipe */
+#define NUMBUF 12
+
+/* Run "left | right": left is spawned with its stdout on a pipe, right
+   runs in the foreground reading it.  Returns right's status. */
+static int32_t run_pipeline (uint8_t* left, uint8_t* right)
+{
+    int32_t fds[2], rval, left_pid;
+
+    if (-1 == ece391_pipe (fds))
+        return -1;
+
+    ece391_dup2 (1, SAVED_FD);
+    ece391_dup2 (fds[1], 1);
+    ece391_close (fds[1]);
+    left_pid = ece391_spawn (left);
+    ece391_dup2 (SAVED_FD, 1);
+    if (-1 == left_pid) {
+        ece391_close (fds[0]);
+        ece391_close (SAVED_FD);
+        return -1;
+    }
+
+    ece391_dup2 (0, SAVED_FD);
+    ece391_dup2 (fds[0], 0);
+    ece391_close (fds[0]);
+    rval = ece391_execute (right);
+    ece391_dup2 (SAVED_FD, 0);
+    ece391_close (SAVED_FD);
+    ece391_waitpid (left_pid, 0, 0);
+    return rval;
+}
+
+/* Split buf at the first '|' and trim the spaces around it; returns the
+   right hand command, or 0 if there is no pipe. */
+static uint8_t* split_pipe (uint8_t* buf)
+{
+    uint8_t* bar;
+    uint8_t* end;
+
+    for (bar = buf; '\0' != *bar && '|' != *bar; bar++);
+    if ('\0' == *bar)
+        return 0;
+    for (end = bar; end > buf && ' ' == end[-1]; end--);
+    *end = '\0';
+    for (bar++; ' ' == *bar; bar++);
+    return bar;
+}
+
+/* Strip a trailing '&' and the spaces around it; returns 1 if there was
+   one, so the command runs in the background. */
+static int32_t split_background (uint8_t* buf)
+{
+    uint8_t* end = buf + ece391_strlen (buf);
+
+    for (; end > buf && ' ' == end[-1]; end--);
+    if (end == buf || '&' != end[-1])
+        return 0;
+    for (end--; end > buf && ' ' == end[-1]; end--);
+    *end = '\0';
+    return 1;
+}
+
+/* Print "[pid] " followed by msg. */
+static void put_job (int32_t pid, const uint8_t* msg)
+{
+    uint8_t num[NUMBUF];
+
+    ece391_fdputs (1, (uint8_t*)"[");
+    ece391_fdputs (1, ece391_itoa (pid, num, 10));
+    ece391_fdputs (1, (uint8_t*)"] ");
+    ece391_fdputs (1, msg);
+}
+
+/* Report background jobs that have finished since the last prompt. */
+static void reap_jobs (void)
+{
+    int32_t pid, status;
+    uint8_t num[NUMBUF];
+
+    while (0 < (pid = ece391_waitpid (WAIT_ANY, &status, WNOHANG))) {
+        put_job (pid, (uint8_t*)"done, status ");
+        ece391_fdputs (1, ece391_itoa (status, num, 10));
+        ece391_fdputs (1, (uint8_t*)"\n");
+    }
+}
 
 int main ()
 {
-    int32_t cnt, rval;
+    int32_t cnt, rval, bg;
     uint8_t buf[BUFSIZE];
+    uint8_t* right;
     ece391_fdputs (1, (uint8_t*)"Starting 391 Shell\n");
 
     while (1) {
+        reap_jobs ();
         ece391_fdputs (1, (uint8_t*)"391OS> ");
 	if (-1 == (cnt = ece391_read (0, buf, BUFSIZE-1))) {
 	    ece391_fdputs (1, (uint8_t*)"read from keyboard failed\n");
@@ -22,9 +110,22 @@ int main ()
 	buf[cnt] = '\0';
 	if (0 == ece391_strcmp (buf, (uint8_t*)"exit"))
 	    return 0;
+	bg = split_background (buf);
 	if ('\0' == buf[0])
 	    continue;
-	rval = ece391_execute (buf);
+	if (bg) {
+	    if (0 != split_pipe (buf))
+		ece391_fdputs (1, (uint8_t*)"pipelines cannot run in the background\n");
+	    else if (-1 == (rval = ece391_spawn (buf)))
+		ece391_fdputs (1, (uint8_t*)"no such command\n");
+	    else
+		put_job (rval, (uint8_t*)"started\n");
+	    continue;
+	}
+	if (0 != (right = split_pipe (buf)))
+	    rval = ('\0' == buf[0] || '\0' == *right) ? -1 : run_pipeline (buf, right);
+	else
+	    rval = ece391_execute (buf);
 	if (-1 == rval)
 	    ece391_fdputs (1, (uint8_t*)"no such command\n");
 	else if (256 == rval)
@@ -2,6 +2,8 @@
 
 #include "ece391support.h"
 #include "ece391syscall.h"
+#include "ece391vdso.h"
+#include "ece391uring.h"
 
 uint32_t ece391_strlen(const uint8_t* s)
 {
@@ -102,3 +104,97 @@ uint8_t* ece391_strrev(uint8_t* s)
    return s;
 }
 
+int32_t ece391_sleep_ms(uint32_t ms)
+{
+    ece391_timespec_t req;
+
+    req.tv_sec = ms / 1000;
+    req.tv_nsec = (ms % 1000) * 1000000;
+    return ece391_nanosleep (&req);
+}
+
+uint64_t ece391_rdtsc (void)
+{
+    uint64_t val;
+
+    asm volatile ("rdtsc" : "=A" (val));
+    return val;
+}
+
+uint64_t ece391_vdso_ns (void)
+{
+    const ece391_vdso_t* vdso = (const ece391_vdso_t*)ECE391_VDSO_ADDR;
+    uint32_t seq, mult, shift;
+    uint64_t tick_tsc, tick_ns, delta, lo, hi;
+
+    do {
+        seq = vdso->seq;
+        asm volatile ("" : : : "memory");
+        mult = vdso->clock_mult;
+        shift = vdso->clock_shift;
+        tick_tsc = vdso->tick_tsc;
+        tick_ns = vdso->tick_ns;
+        asm volatile ("" : : : "memory");
+    } while ((seq & 1) || seq != vdso->seq);
+
+    /* (delta * mult) >> shift without a 64-bit multiply from libgcc */
+    delta = ece391_rdtsc () - tick_tsc;
+    lo = (uint64_t)(uint32_t)delta * mult;
+    hi = (uint64_t)(uint32_t)(delta >> 32) * mult;
+    return tick_ns + (hi << (32 - shift)) + (lo >> shift);
+}
+
+int32_t ece391_vdso_gettime (ece391_timespec_t* ts)
+{
+    uint64_t now = ece391_vdso_ns ();
+    uint32_t sec, nsec;
+
+    asm ("divl %4" : "=a" (sec), "=d" (nsec)
+         : "a" ((uint32_t)now), "d" ((uint32_t)(now >> 32)), "rm" (1000000000));
+    ts->tv_sec = sec;
+    ts->tv_nsec = nsec;
+    return 0;
+}
+
+uint32_t ece391_vdso_pit_ticks (void)
+{
+    return ((const ece391_vdso_t*)ECE391_VDSO_ADDR)->pit_ticks;
+}
+
+uint32_t ece391_vdso_rtc_ticks (void)
+{
+    return ((const ece391_vdso_t*)ECE391_VDSO_ADDR)->rtc_ticks;
+}
+
+int32_t ece391_uring_queue(ece391_uring_t* ring, uint32_t opcode, int32_t fd,
+                           const void* addr, int32_t len, uint32_t user_data)
+{
+    ece391_uring_sqe_t* sqe;
+
+    if (ring->sq_tail - ring->sq_head >= ECE391_URING_ENTRIES)
+        return -1;
+    sqe = &ring->sqes[ring->sq_tail & ECE391_URING_MASK];
+    sqe->opcode = opcode;
+    sqe->fd = fd;
+    sqe->addr = (uint32_t)addr;
+    sqe->len = len;
+    sqe->user_data = user_data;
+    asm volatile ("" : : : "memory");
+    ring->sq_tail++;
+    return 0;
+}
+
+int32_t ece391_uring_submit(ece391_uring_t* ring)
+{
+    return ece391_uring_enter (ring->sq_tail - ring->sq_head);
+}
+
+int32_t ece391_uring_reap(ece391_uring_t* ring, ece391_uring_cqe_t* cqe)
+{
+    if (ring->cq_head == ring->cq_tail)
+        return 0;
+    *cqe = ring->cqes[ring->cq_head & ECE391_URING_MASK];
+    asm volatile ("" : : : "memory");
+    ring->cq_head++;
+    return 1;
+}
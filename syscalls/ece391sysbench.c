@@ -0,0 +1,88 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+#include "ece391vdso.h"
+
+/*
+ * Null system call latency for INT 0x80 and SYSENTER.  System call 0 is
+ * rejected by the kernel's range check right after entry, so each call
+ * measures only the trip into the kernel and back.  The numbers only mean
+ * something on real hardware or under hardware virtualization; an
+ * emulator that traps both instructions times itself instead.
+ */
+
+#define ITERATIONS 10000
+#define ROUNDS     5
+
+static inline int32_t null_int80 (void)
+{
+    int32_t ret;
+    asm volatile ("int $0x80"
+                  : "=a" (ret)
+                  : "0" (0)
+                  : "ecx", "edx", "memory");
+    return ret;
+}
+
+static inline int32_t null_sysenter (void)
+{
+    int32_t ret;
+    asm volatile ("pushl %%ebp\n\t"
+                  "movl %%esp, %%ebp\n\t"
+                  "movl $1f, %%esi\n\t"
+                  "sysenter\n"
+                  "1:\tpopl %%ebp"
+                  : "=a" (ret)
+                  : "0" (0)
+                  : "ecx", "edx", "esi", "memory");
+    return ret;
+}
+
+/* Best of ROUNDS, in cycles per call.  One round stays well below 2^32
+   cycles, so the low halves of the TSC are enough. */
+static uint32_t measure (int32_t (*call) (void))
+{
+    uint32_t round, i, start, cycles, best = 0xFFFFFFFF;
+
+    for (round = 0; round < ROUNDS; round++) {
+        start = (uint32_t)ece391_rdtsc ();
+        for (i = 0; i < ITERATIONS; i++)
+            (void)call ();
+        cycles = ((uint32_t)ece391_rdtsc () - start) / ITERATIONS;
+        if (cycles < best)
+            best = cycles;
+    }
+    return best;
+}
+
+static void report (const char* name, uint32_t cycles, uint32_t khz)
+{
+    uint8_t buf[16];
+
+    ece391_fdputs (1, (uint8_t*)name);
+    ece391_fdputs (1, ece391_itoa (cycles, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" cycles, ");
+    ece391_fdputs (1, ece391_itoa (cycles * 1000 / khz, buf, 10));
+    ece391_fdputs (1, (uint8_t*)" ns per call\n");
+}
+
+int main ()
+{
+    const ece391_vdso_t* vdso = (const ece391_vdso_t*)ECE391_VDSO_ADDR;
+    uint32_t khz = vdso->tsc_khz;
+
+    if (null_int80 () != -1) {
+        ece391_fdputs (1, (uint8_t*)"system call 0 did not fail\n");
+        return 2;
+    }
+    report ("int 0x80: ", measure (null_int80), khz);
+
+    if (!(vdso->features & ECE391_VDSO_SYSENTER)) {
+        ece391_fdputs (1, (uint8_t*)"sysenter: not supported by this kernel\n");
+        return 0;
+    }
+    report ("sysenter: ", measure (null_sysenter), khz);
+
+    return 0;
+}
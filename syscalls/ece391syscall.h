@@ -19,9 +19,151 @@ extern int32_t ece391_open (const uint8_t* filename);
 extern int32_t ece391_close (int32_t fd);
 extern int32_t ece391_getargs (uint8_t* buf, int32_t nbytes);
 extern int32_t ece391_vidmap (uint8_t** screen_start);
+
+/*
+ * set_handler installs handler(signum) for a signal, 0 restores the
+ * default: DIV_ZERO, SEGFAULT (any other fault) and INTERRUPT (ctrl+C)
+ * halt the program, ALARM (every 10 seconds) and USER1 are ignored.
+ * Other signals are held back while a handler runs.  The handler may edit
+ * the saved registers that follow signum on its stack; returning calls
+ * sigreturn, which programs never call themselves.  A signal that runs a
+ * handler or halts the program also wakes a blocked call (read, nanosleep,
+ * waitpid, thread_join, futex_wait, poll), which then returns -1; a pipe
+ * write returns the bytes already written if there are any.
+ */
 extern int32_t ece391_set_handler (int32_t signum, void* handler);
 extern int32_t ece391_sigreturn (void);
 
+/*
+ * ioctl on a terminal fd: IOCTL_GET_MODE returns the mode bits,
+ * IOCTL_SET_MODE replaces them.  In TERM_RAW mode each byte read is one
+ * key event (a scan code, releases have the top bit set) and nothing is
+ * echoed; with TERM_NONBLOCK a read returns 0 if no input is pending.
+ */
+extern int32_t ece391_ioctl (int32_t fd, int32_t cmd, int32_t arg);
+
+#define IOCTL_GET_MODE 0
+#define IOCTL_SET_MODE 1
+#define TERM_RAW       0x1
+#define TERM_NONBLOCK  0x2
+
+/*
+ * clock_gettime fills ts with the time since boot, measured with the
+ * calibrated TSC, to the nanosecond.
+ */
+typedef struct ece391_timespec {
+	uint32_t tv_sec;
+	uint32_t tv_nsec;
+} ece391_timespec_t;
+
+#define CLOCK_MONOTONIC 0
+
+extern int32_t ece391_clock_gettime (int32_t clock_id, ece391_timespec_t* ts);
+
+/*
+ * nanosleep blocks the caller for at least req; it is woken on the first
+ * timer tick (10 ms) after the time has passed.
+ */
+extern int32_t ece391_nanosleep (const ece391_timespec_t* req);
+
+/*
+ * pipe stores a read end in fds[0] and a write end in fds[1].  Reads
+ * block until data arrives and return 0 once every write end is closed;
+ * writes block while the pipe is full and fail once every read end is
+ * closed.  dup2 makes newfd (which may be 0 or 1) refer to the file of
+ * oldfd.  spawn starts a program without waiting for it and returns its
+ * pid; the child shares the terminal and inherits fds 0 and 1, as a
+ * child of execute does.
+ */
+extern int32_t ece391_pipe (int32_t* fds);
+extern int32_t ece391_dup2 (int32_t oldfd, int32_t newfd);
+extern int32_t ece391_spawn (const uint8_t* command);
+
+/*
+ * waitpid collects a halted child started by spawn (pid, or any with
+ * WAIT_ANY), stores its halt status in *status unless status is 0 and
+ * returns its pid.  It sleeps until such a child halts; with WNOHANG it
+ * returns 0 instead.  It fails if the caller has no such child.  A child
+ * stays allocated until it is collected or its parent halts.
+ */
+#define WAIT_ANY (-1)
+#define WNOHANG  1
+
+extern int32_t ece391_waitpid (int32_t pid, int32_t* status, int32_t options);
+
+/*
+ * thread_create starts a thread running entry(arg) in the calling program
+ * on the stack that ends at stack_top, and returns its thread id.  Threads
+ * share the program's memory, shared segments and open files, and each
+ * has its own stack and signal state.  A thread ends when entry returns
+ * (its return value is the status), by thread_exit, or by halt or a
+ * fault, which end only that thread.  thread_join waits for a thread of
+ * the same program to end and stores its status in *status unless status
+ * is 0; each thread must be joined once to free it.  When the program
+ * itself halts, its remaining threads end with it.
+ */
+extern int32_t ece391_thread_create (int32_t (*entry)(void*), void* arg, void* stack_top);
+extern int32_t ece391_thread_join (int32_t tid, int32_t* status);
+extern int32_t ece391_thread_exit (int32_t status);
+
+/*
+ * profile starts the kernel's sampling profiler at hz samples per second
+ * (a power of two up to 1024), dropping the samples of the last run, or
+ * stops it when hz is 0.  The samples are read as text from the file
+ * "profile", one per line: pid, program name, k or u for kernel or user
+ * mode, then eip and the return addresses above it, in hex.
+ */
+extern int32_t ece391_profile (int32_t hz);
+
+/*
+ * shm_get returns the id of the shared segment called name, creating it
+ * zero filled with size bytes (at most 32 kB) if it does not exist yet.
+ * shm_attach maps the segment and stores its address in *addr; every
+ * process sees a segment at the same address.  A process holds every
+ * segment it got or attached until shm_detach, which also unmaps it, and
+ * the segment is freed once no process holds it.  Halting detaches
+ * everything.
+ */
+extern int32_t ece391_shm_get (const uint8_t* name, uint32_t size);
+extern int32_t ece391_shm_attach (int32_t id, uint8_t** addr);
+extern int32_t ece391_shm_detach (int32_t id);
+
+/*
+ * futex_wait sleeps while the aligned word at addr still holds val and
+ * returns 0 once woken, or -1 at once if the word has changed.  There is
+ * no timeout: if the waker never comes, for instance because the program
+ * holding a lock died, the wait lasts until a signal such as ctrl+C ends
+ * it with -1.  futex_wake
+ * wakes up to n sleepers on the word and returns how many it woke.  The
+ * word may live in a shared segment to synchronize separate programs.
+ * Woken waiters must check the word again.
+ */
+extern int32_t ece391_futex_wait (uint32_t* addr, uint32_t val);
+extern int32_t ece391_futex_wake (uint32_t* addr, uint32_t n);
+
+/*
+ * poll waits until one of up to 8 fds is ready for the events asked for,
+ * or timeout_ms passes (0 only checks, negative waits forever).  It fills
+ * in revents of every entry and returns how many are set, 0 on timeout.
+ * The terminal is readable once a line (or, in TERM_RAW mode, a key
+ * event) is waiting, an RTC file once its timer fired since the last
+ * read, a pipe once it has data or no writers.  Files on disk are always
+ * ready.
+ */
+typedef struct ece391_pollfd {
+	int32_t fd;
+	int16_t events;
+	int16_t revents;
+} ece391_pollfd_t;
+
+#define POLLIN   0x01
+#define POLLOUT  0x04
+#define POLLERR  0x08
+#define POLLHUP  0x10
+#define POLLNVAL 0x20
+
+extern int32_t ece391_poll (ece391_pollfd_t* fds, uint32_t nfds, int32_t timeout_ms);
+
 enum signums {
 	DIV_ZERO = 0,
 	SEGFAULT,
@@ -11,5 +11,24 @@
 #define SYS_VIDMAP  8
 #define SYS_SET_HANDLER  9
 #define SYS_SIGRETURN  10
+#define SYS_IOCTL   11
+#define SYS_CLOCK_GETTIME   12
+#define SYS_NANOSLEEP   13
+#define SYS_URING_SETUP 14
+#define SYS_URING_ENTER 15
+#define SYS_PIPE    16
+#define SYS_DUP2    17
+#define SYS_SPAWN   18
+#define SYS_SHM_GET 19
+#define SYS_SHM_ATTACH 20
+#define SYS_SHM_DETACH 21
+#define SYS_FUTEX_WAIT 22
+#define SYS_FUTEX_WAKE 23
+#define SYS_POLL 24
+#define SYS_WAITPID 25
+#define SYS_THREAD_CREATE 26
+#define SYS_THREAD_JOIN 27
+#define SYS_THREAD_EXIT 28
+#define SYS_PROFILE 29
 
 #endif /* ECE391SYSNUM_H */
@@ -0,0 +1,36 @@
+#include <stdint.h>
+
+#include "ece391support.h"
+#include "ece391syscall.h"
+
+/*
+ * sysstat prints the kernel's system call tables from the file "syscalls":
+ * per call the number of calls, the average cycles and a log2 histogram of
+ * the cycles (bucket:count), then the calls of each live process.
+ * "sysstat clear" clears the system wide table first, so that
+ * "sysstat clear", a workload, then "sysstat" shows the workload's calls.
+ */
+
+#define BUFSIZE 1024
+
+int main ()
+{
+    int32_t fd, cnt;
+    uint8_t buf[BUFSIZE];
+
+    if (-1 == (fd = ece391_open ((uint8_t*)"syscalls"))) {
+        ece391_fdputs (1, (uint8_t*)"no system call statistics in this kernel\n");
+        return 2;
+    }
+    if (0 == ece391_getargs (buf, BUFSIZE) && 0 == ece391_strcmp (buf, (uint8_t*)"clear")) {
+        ece391_write (fd, buf, 1);
+        ece391_close (fd);
+        return 0;
+    }
+    while (0 < (cnt = ece391_read (fd, buf, BUFSIZE))) {
+        if (-1 == ece391_write (1, buf, cnt))
+            return 3;
+    }
+    ece391_close (fd);
+    return 0;
+}
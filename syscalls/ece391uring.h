@@ -0,0 +1,56 @@
+#if !defined(ECE391URING_H)
+#define ECE391URING_H
+
+#include <stdint.h>
+
+/*
+ * Submission and completion rings for batching system calls.  Register
+ * an ece391_uring_t (a global, it must stay valid) with ece391_uring_setup,
+ * queue requests, then run the whole batch with one ece391_uring_enter.
+ * The layout matches uring_t in the kernel.  Each completion carries the
+ * user_data of its request and what the system call returned.
+ */
+#define ECE391_URING_ENTRIES 64
+#define ECE391_URING_MASK    (ECE391_URING_ENTRIES - 1)
+
+#define URING_OP_NOP   0
+#define URING_OP_READ  1	/* read (fd, addr, len) */
+#define URING_OP_WRITE 2	/* write (fd, addr, len) */
+#define URING_OP_OPEN  3	/* open (addr) */
+#define URING_OP_CLOSE 4	/* close (fd) */
+
+typedef struct ece391_uring_sqe {
+	uint32_t opcode;
+	int32_t fd;
+	uint32_t addr;
+	int32_t len;
+	uint32_t user_data;
+} ece391_uring_sqe_t;
+
+typedef struct ece391_uring_cqe {
+	uint32_t user_data;
+	int32_t res;
+} ece391_uring_cqe_t;
+
+typedef struct ece391_uring {
+	volatile uint32_t sq_head;
+	volatile uint32_t sq_tail;
+	volatile uint32_t cq_head;
+	volatile uint32_t cq_tail;
+	ece391_uring_sqe_t sqes[ECE391_URING_ENTRIES];
+	ece391_uring_cqe_t cqes[ECE391_URING_ENTRIES];
+} ece391_uring_t;
+
+extern int32_t ece391_uring_setup (ece391_uring_t* ring);
+/* Returns the number of requests run; stops early if the completion ring fills. */
+extern int32_t ece391_uring_enter (uint32_t to_submit);
+
+/* Queue a request; -1 if the submission ring is full. */
+extern int32_t ece391_uring_queue (ece391_uring_t* ring, uint32_t opcode,
+		int32_t fd, const void* addr, int32_t len, uint32_t user_data);
+/* Run everything queued; returns the number of requests run. */
+extern int32_t ece391_uring_submit (ece391_uring_t* ring);
+/* Take one completion; 0 if there is none. */
+extern int32_t ece391_uring_reap (ece391_uring_t* ring, ece391_uring_cqe_t* cqe);
+
+#endif /* ECE391URING_H */
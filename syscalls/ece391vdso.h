@@ -0,0 +1,39 @@
+#if !defined(ECE391VDSO_H)
+#define ECE391VDSO_H
+
+#include <stdint.h>
+#include "ece391syscall.h"
+
+/*
+ * The kernel maps a read-only time page at ECE391_VDSO_ADDR in every
+ * program and refreshes it on each PIT tick, so time can be read without
+ * a system call.  The layout matches vdso_data_t in the kernel.  seq is
+ * odd while the kernel writes; readers retry until they see the same even
+ * value before and after copying.
+ */
+#define ECE391_VDSO_ADDR 0x08401000
+
+/* features bits */
+#define ECE391_VDSO_SYSENTER 0x1	/* SYSENTER system calls are available */
+
+typedef struct ece391_vdso {
+	volatile uint32_t seq;
+	uint32_t pit_ticks;
+	uint32_t rtc_ticks;
+	uint32_t tsc_khz;
+	uint32_t clock_mult;
+	uint32_t clock_shift;
+	uint64_t tsc_base;
+	uint64_t tick_tsc;
+	uint64_t tick_ns;
+	uint32_t features;
+} ece391_vdso_t;
+
+/* Nanoseconds since boot, the same clock as ece391_clock_gettime. */
+extern uint64_t ece391_vdso_ns (void);
+extern int32_t ece391_vdso_gettime (ece391_timespec_t* ts);
+extern uint32_t ece391_vdso_pit_ticks (void);
+extern uint32_t ece391_vdso_rtc_ticks (void);
+extern uint64_t ece391_rdtsc (void);
+
+#endif /* ECE391VDSO_H */